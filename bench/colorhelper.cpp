@@ -0,0 +1,110 @@
+// Checks and times the pixel kernels of src/uilib/colorhelper.cpp.
+// Every vectorized variant the cpu supports has to produce output that is
+// bit-identical to the scalar code, otherwise this returns 1.
+// Build and run with `make bench`.
+
+#define SDL_MAIN_HANDLED
+#include "../src/uilib/colorhelper.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+
+static const char* LEVEL_NAMES[] = { "scalar", "sse2", "avx2" };
+static constexpr int LEVEL_COUNT = 3;
+static constexpr int WIDTH = 1023; // not a multiple of the vector width to cover the tail
+static constexpr int HEIGHT = 1024;
+static constexpr int RUNS = 20;
+
+static SDL_Surface* makeTestSurface(Uint32 format, uint32_t key)
+{
+    SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, format);
+    if (!surf) {
+        fprintf(stderr, "Could not create surface: %s\n", SDL_GetError());
+        return nullptr;
+    }
+    uint32_t state = 0x12345678;
+    for (int y=0; y<surf->h; y++) {
+        auto row = (uint32_t*)((uint8_t*)surf->pixels + y * surf->pitch);
+        for (int x=0; x<surf->w; x++) {
+            // xorshift32, with some pixels being the color key
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            row[x] = (state % 7 == 0) ? key : state;
+        }
+    }
+    return surf;
+}
+
+template<class F>
+static bool check(const char* name, SDL_Surface* src, F kernel)
+{
+    size_t bytes = (size_t)src->pitch * src->h;
+    SDL_Surface* expected = nullptr;
+    double scalarTime = 0;
+    bool ok = true;
+    printf("%-28s", name);
+    for (int level=0; level<LEVEL_COUNT; level++) {
+        if (setColorHelperSimdLimit(level) != level)
+            continue; // not supported by this cpu or target
+        SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, src->w, src->h, 32, src->format->format);
+        if (!surf) {
+            ok = false;
+            break;
+        }
+        std::chrono::steady_clock::duration total{};
+        for (int i=0; i<RUNS; i++) {
+            memcpy(surf->pixels, src->pixels, bytes);
+            auto start = std::chrono::steady_clock::now();
+            kernel(surf);
+            total += std::chrono::steady_clock::now() - start;
+        }
+        double ms = std::chrono::duration<double, std::milli>(total).count() / RUNS;
+        if (level == 0) {
+            expected = surf;
+            scalarTime = ms;
+            printf("  %s %.2fms", LEVEL_NAMES[level], ms);
+            continue;
+        }
+        bool same = memcmp(surf->pixels, expected->pixels, bytes) == 0;
+        printf("  %s %.2fms (%.1fx)%s", LEVEL_NAMES[level], ms, scalarTime / ms, same ? "" : " MISMATCH");
+        if (!same) ok = false;
+        SDL_FreeSurface(surf);
+    }
+    printf("\n");
+    if (expected) SDL_FreeSurface(expected);
+    setColorHelperSimdLimit(LEVEL_COUNT - 1);
+    return ok;
+}
+
+int main(int, char**)
+{
+    static const struct {
+        const char* name;
+        Uint32 format;
+    } formats[] = {
+        { "ARGB8888", SDL_PIXELFORMAT_ARGB8888 },
+        { "ABGR8888", SDL_PIXELFORMAT_ABGR8888 },
+        { "RGBX8888", SDL_PIXELFORMAT_RGBX8888 },
+    };
+    const uint32_t key = 0xffff00ff;
+    bool ok = true;
+    for (const auto& format: formats) {
+        SDL_Surface* src = makeTestSurface(format.format, key);
+        if (!src) return 1;
+        std::string name = std::string("greyscale ") + format.name;
+        ok = check(name.c_str(), src, [](SDL_Surface* surf) { makeGreyscale32(surf, false); }) && ok;
+        name += " dark";
+        ok = check(name.c_str(), src, [](SDL_Surface* surf) { makeGreyscale32(surf, true); }) && ok;
+        name = std::string("replace ") + format.name;
+        ok = check(name.c_str(), src, [key](SDL_Surface* surf) { replaceColor32(surf, key, 0); }) && ok;
+        SDL_FreeSurface(src);
+    }
+    if (!ok) {
+        fprintf(stderr, "Vectorized kernels differ from the scalar code!\n");
+        return 1;
+    }
+    return 0;
+}
@@ -76,6 +76,7 @@ LayoutNode LayoutNode::FromJSON(json& j)
 {
     LayoutNode node;
     
+    node._hash        = std::hash<json>{}(j); // before we touch j below
     node._type        = to_string(j["type"],""); // TODO: enum
     node._background  = to_string(j["background"],"");
     node._hAlignment  = to_string(j["h_alignment"],""); // TODO: enum
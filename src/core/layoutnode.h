@@ -75,6 +75,7 @@ protected:
     std::list<std::string> _maps;
     std::list<LayoutNode> _content;
     Size _position;
+    size_t _hash = 0;
 
 public:
     // TODO: more getters
@@ -100,6 +101,8 @@ public:
     const std::string& getItemHAlignment() const { return _itemHAlign; }
     const std::string& getItemVAlignment() const { return _itemVAlign; }
     const Size& getPosition() const { return _position; }
+    // hash of the source json, equal hashes result in equal nodes
+    size_t getHash() const { return _hash; }
     OptionalBool getDropShadow() const { return _dropShadow; }
     bool getDropShadow(bool dflt) const { return _dropShadow == OptionalBool::True ? true :
                                                  _dropShadow == OptionalBool::False ? false : dflt; }
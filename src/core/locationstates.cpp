@@ -0,0 +1,120 @@
+#include "locationstates.h"
+#include "tracker.h"
+#include "perfstats.h"
+
+
+LocationStates::LocationStates(Tracker* tracker)
+    : _tracker(tracker)
+{
+    _tracker->onStateChanged += {this, [this](void*, const std::string&) {
+        update();
+    }};
+    _tracker->onLocationSectionChanged += {this, [this](void*, const LocationSection&) {
+        update();
+    }};
+    _tracker->onLayoutChanged += {this, [this](void*, const std::string& layout) {
+        // locations may have been added or replaced, views requery after relayout
+        if (layout.empty()) _states.clear();
+    }};
+}
+
+LocationStates::~LocationStates()
+{
+    _tracker->onStateChanged -= this;
+    _tracker->onLocationSectionChanged -= this;
+    _tracker->onLayoutChanged -= this;
+}
+
+int LocationStates::getState(const std::string& locid)
+{
+    auto it = _states.find(locid);
+    if (it != _states.end()) return it->second;
+    int state = calculateState(locid);
+    _states[locid] = state;
+    return state;
+}
+
+void LocationStates::update()
+{
+    if (_updating) {
+        // a change from inside a Lua rule, run again when done
+        _dirty = true;
+        return;
+    }
+    PerfStats::Timer timer(PerfStats::Section::LOCATIONS);
+    std::set<std::string> changed;
+    _updating = true;
+    do {
+        _dirty = false;
+        for (auto& pair: _states) {
+            int state = calculateState(pair.first);
+            if (state != pair.second) {
+                pair.second = state;
+                changed.insert(pair.first);
+            }
+        }
+    } while (_dirty);
+    _updating = false;
+    onChanged.emit(this, changed);
+}
+
+int LocationStates::calculateState(const std::string& locid)
+{
+    auto& loc = _tracker->getLocation(locid);
+    bool hasReachable = false;
+    bool hasUnreachable = false;
+    bool hasGlitchedReachable = false;
+    bool hasCheckable = false;
+    bool hasVisible = false;
+
+    for (const auto& ogSec: loc.getSections()) {
+        const auto& sec = ogSec.getRef().empty() ? ogSec : _tracker->getLocationSection(ogSec.getRef());
+
+        if (!_tracker->isVisible(loc, sec))
+            continue;
+
+        std::list<std::string> hostedItems;
+        if (sec.getItemCleared() >= sec.getItemCount()) {
+            // be lazy about filling hostedItems
+            for (const auto& code : sec.getHostedItems()) {
+                if (_tracker->getItemByCode(code).getType() != BaseItem::Type::NONE)
+                    hostedItems.push_back(code);
+            }
+            // ignore section if empty
+            if (sec.getItemCount() < 1 && hostedItems.size() < 1)
+                continue;
+        }
+
+        hasVisible = true;
+
+        if (sec.getItemCleared() >= sec.getItemCount()) {
+            // check hosted items
+            bool missing = false;
+            for (const auto& code: hostedItems) {
+                if (!_tracker->ProviderCountForCode(code)) {
+                    missing = true;
+                    break;
+                }
+            }
+            if (!missing) continue;
+        }
+
+        auto reachable = _tracker->isReachable(loc, sec);
+        if (reachable == AccessibilityLevel::NORMAL) {
+            hasReachable = true;
+        } else if (reachable == AccessibilityLevel::NONE) {
+            hasUnreachable = true;
+        } else if (reachable == AccessibilityLevel::INSPECT) {
+            hasCheckable = true;
+        } else {
+            hasGlitchedReachable = true;
+        }
+        if (hasReachable && hasUnreachable && hasGlitchedReachable && hasCheckable) break;
+    }
+    if (!hasVisible) return -1;
+    uint8_t res = (hasCheckable?(1<<3):0) |
+                  (hasGlitchedReachable?(1<<2):0) |
+                  (hasUnreachable?(1<<1):0) |
+                  (hasReachable?(1<<0):0);
+    return res;
+}
@@ -0,0 +1,38 @@
+#ifndef _CORE_LOCATIONSTATES_H
+#define _CORE_LOCATIONSTATES_H
+
+#include "signal.h"
+#include <string>
+#include <map>
+#include <set>
+
+
+class Tracker;
+
+// Location states (map marker colors) shared by all views of a tracker.
+// States are only kept for locations that were queried with getState() and
+// get recalculated once per tracker change, then onChanged is emitted with
+// the locations that actually changed.
+class LocationStates final {
+public:
+    LocationStates(Tracker* tracker);
+    ~LocationStates();
+
+    // -1 if nothing is visible, otherwise a bit field of
+    // 1<<0 reachable, 1<<1 unreachable, 1<<2 glitched, 1<<3 checkable
+    int getState(const std::string& locid);
+
+    // emitted after every update, the set may be empty if nothing changed
+    Signal<const std::set<std::string>&> onChanged;
+
+private:
+    Tracker* _tracker;
+    std::map<std::string, int> _states;
+    bool _updating = false;
+    bool _dirty = false;
+
+    void update();
+    int calculateState(const std::string& locid);
+};
+
+#endif // _CORE_LOCATIONSTATES_H
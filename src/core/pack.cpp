@@ -156,9 +156,22 @@ read_err:
     }
 }
 
+bool Pack::ReadFileCached(const std::string& file, std::string& out) const
+{
+    auto it = _fileCache.find(file);
+    if (it == _fileCache.end()) {
+        std::string data;
+        bool ok = ReadFile(file, data);
+        it = _fileCache.emplace(file, std::make_pair(ok, std::move(data))).first;
+    }
+    out = it->second.second;
+    return it->second.first;
+}
+
 void Pack::setVariant(const std::string& variant)
 {
     // set variant and cache some common values
+    _fileCache.clear(); // files may resolve differently
     _variant = variant;
     _variantName = variant; // fall-back
     if (_manifest.type() != json::value_t::object) return;
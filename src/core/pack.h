@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
 #include <chrono>
 #include <nlohmann/json.hpp>
 #include "zip.h"
@@ -51,6 +52,9 @@ public:
     
     bool hasFile(const std::string& file) const;
     bool ReadFile(const std::string& file, std::string& out) const;
+    // same as ReadFile, but keeps the result for the lifetime of the Pack;
+    // for small files that are read many times, i.e. image overlays
+    bool ReadFileCached(const std::string& file, std::string& out) const;
     
     bool variantHasFlag(const std::string& flag) const;
     std::set<std::string> getVariantFlags() const;
@@ -78,6 +82,8 @@ protected:
 
     std::chrono::system_clock::time_point _loaded;
 
+    mutable std::map<std::string, std::pair<bool, std::string>> _fileCache; // see ReadFileCached
+
     static std::vector<std::string> _searchPaths;
 };
 
@@ -0,0 +1,161 @@
+#include "perfstats.h"
+#include <stdio.h>
+#include <algorithm>
+
+
+std::vector<PerfStats::Frame> PerfStats::_frames;
+size_t PerfStats::_nextFrame = 0;
+PerfStats::Frame PerfStats::_current = {};
+PerfStats::Section PerfStats::_section = PerfStats::Section::OTHER;
+PerfStats::clock::time_point PerfStats::_sectionStart = PerfStats::clock::now();
+PerfStats::clock::time_point PerfStats::_frameStart = PerfStats::clock::now();
+
+static uint32_t toMicros(std::chrono::steady_clock::duration d)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    return (us < 0) ? 0 : (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+}
+
+PerfStats::Timer::Timer(Section section)
+{
+    _prev = _section;
+    switchSection(section);
+}
+
+PerfStats::Timer::~Timer()
+{
+    switchSection(_prev);
+}
+
+void PerfStats::switchSection(Section section)
+{
+    auto now = clock::now();
+    _current.sections[(size_t)_section] += toMicros(now - _sectionStart);
+    _sectionStart = now;
+    _section = section;
+}
+
+void PerfStats::endFrame()
+{
+    auto now = clock::now();
+    _current.sections[(size_t)_section] += toMicros(now - _sectionStart);
+    _sectionStart = now;
+    _current.total = toMicros(now - _frameStart);
+    _frameStart = now;
+    if (_frames.size() < HISTORY)
+        _frames.push_back(_current);
+    else
+        _frames[_nextFrame] = _current;
+    _nextFrame = (_nextFrame + 1) % HISTORY;
+    _current = {};
+}
+
+const char* PerfStats::getSectionName(Section section)
+{
+    switch (section) {
+        case Section::EVENTS: return "events";
+        case Section::ASIO: return "asio";
+        case Section::AUTOTRACKER: return "autotracker";
+        case Section::LUA: return "lua";
+        case Section::LOCATIONS: return "locations";
+        case Section::RENDER: return "render";
+        default: return "other"; // includes waiting for the next frame
+    }
+}
+
+size_t PerfStats::getFrameCount()
+{
+    return _frames.size();
+}
+
+uint32_t PerfStats::getPercentile(unsigned p)
+{
+    if (_frames.empty()) return 0;
+    std::vector<uint32_t> times;
+    times.reserve(_frames.size());
+    for (const auto& frame: _frames)
+        times.push_back(frame.total);
+    size_t n = std::min(times.size() - 1, (times.size() * p) / 100);
+    std::nth_element(times.begin(), times.begin() + n, times.end());
+    return times[n];
+}
+
+uint32_t PerfStats::getAverage(Section section)
+{
+    if (_frames.empty()) return 0;
+    uint64_t sum = 0;
+    for (const auto& frame: _frames)
+        sum += frame.sections[(size_t)section];
+    return (uint32_t)(sum / _frames.size());
+}
+
+uint32_t PerfStats::getMaxLayoutPasses()
+{
+    uint32_t res = 0;
+    for (const auto& frame: _frames)
+        res = std::max(res, frame.layoutPasses);
+    return res;
+}
+
+std::vector<unsigned> PerfStats::getHistogram()
+{
+    std::vector<unsigned> res(HISTOGRAM_BUCKETS, 0);
+    for (const auto& frame: _frames) {
+        size_t i = 0;
+        while (i < HISTOGRAM_BUCKETS-1 && frame.total > HISTOGRAM_LIMITS[i]*1000) i++;
+        res[i]++;
+    }
+    return res;
+}
+
+std::string PerfStats::getSummary(const std::string& extra)
+{
+    char buf[128];
+    std::string s;
+    snprintf(buf, sizeof(buf), "frame: p50 %.1fms  p90 %.1fms  p99 %.1fms  max %.1fms (%u frames)\n",
+            getPercentile(50)/1000.f, getPercentile(90)/1000.f, getPercentile(99)/1000.f,
+            getPercentile(100)/1000.f, (unsigned)getFrameCount());
+    s += buf;
+    for (size_t i=1; i<SECTION_COUNT; i++) {
+        snprintf(buf, sizeof(buf), "%-12s %6.2fms\n", getSectionName((Section)i), getAverage((Section)i)/1000.f);
+        s += buf;
+    }
+    snprintf(buf, sizeof(buf), "layout passes: max %u per frame\n", (unsigned)getMaxLayoutPasses());
+    s += buf;
+    s += extra;
+    return s;
+}
+
+bool PerfStats::exportTo(const std::string& filename, const std::string& extra)
+{
+    FILE* f = fopen(filename.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "PerfStats: could not write %s\n", filename.c_str());
+        return false;
+    }
+    std::string s = getSummary(extra);
+    fprintf(f, "%s\nhistogram:\n", s.c_str());
+    auto histogram = getHistogram();
+    for (size_t i=0; i<HISTOGRAM_BUCKETS; i++) {
+        if (i < HISTOGRAM_BUCKETS-1)
+            fprintf(f, "<=%3ums %u\n", HISTOGRAM_LIMITS[i], histogram[i]);
+        else
+            fprintf(f, " >%3ums %u\n", HISTOGRAM_LIMITS[i-1], histogram[i]);
+    }
+    // frames in order, times in us
+    fprintf(f, "\ntotal");
+    for (size_t i=0; i<SECTION_COUNT; i++)
+        fprintf(f, ",%s", getSectionName((Section)i));
+    fprintf(f, ",layout passes\n");
+    size_t start = (_frames.size() < HISTORY) ? 0 : _nextFrame;
+    for (size_t n=0; n<_frames.size(); n++) {
+        const auto& frame = _frames[(start + n) % _frames.size()];
+        fprintf(f, "%u", (unsigned)frame.total);
+        for (size_t i=0; i<SECTION_COUNT; i++)
+            fprintf(f, ",%u", (unsigned)frame.sections[i]);
+        fprintf(f, ",%u\n", (unsigned)frame.layoutPasses);
+    }
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
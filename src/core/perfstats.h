@@ -0,0 +1,79 @@
+#ifndef _CORE_PERFSTATS_H
+#define _CORE_PERFSTATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+// Frame time statistics for the performance HUD and bug reports.
+// Time is accounted to the innermost running Timer, so nested sections
+// (i.e. Lua callbacks from auto-tracking) are not counted twice.
+// Not thread-safe, only use from the main thread.
+class PerfStats final {
+public:
+    enum class Section {
+        OTHER = 0,
+        EVENTS,
+        ASIO,
+        AUTOTRACKER,
+        LUA,
+        LOCATIONS,
+        RENDER,
+        COUNT
+    };
+    static constexpr size_t SECTION_COUNT = (size_t)Section::COUNT;
+    static constexpr size_t HISTORY = 1024; // frames to keep
+    // upper limits of histogram buckets in ms, the last bucket has no limit
+    static constexpr unsigned HISTOGRAM_LIMITS[] = { 2, 4, 8, 12, 17, 25, 34, 50, 100 };
+    static constexpr size_t HISTOGRAM_BUCKETS = sizeof(HISTOGRAM_LIMITS)/sizeof(HISTOGRAM_LIMITS[0]) + 1;
+
+    struct Frame {
+        uint32_t total; // us
+        uint32_t sections[SECTION_COUNT]; // us
+        uint32_t layoutPasses; // should be 0 unless the ui changed
+    };
+
+    class Timer final {
+    public:
+        Timer(Section section);
+        ~Timer();
+    private:
+        Section _prev;
+    };
+
+    // call once per frame, after rendering
+    static void endFrame();
+    // called by ui containers for every layout pass
+    static void countLayoutPass() { _current.layoutPasses++; }
+
+    static const char* getSectionName(Section section);
+    static size_t getFrameCount();
+    // frame time in us at percentile p (0..100) over the kept frames
+    static uint32_t getPercentile(unsigned p);
+    // average time per frame in us
+    static uint32_t getAverage(Section section);
+    // highest number of layout passes in a single frame over the kept frames
+    static uint32_t getMaxLayoutPasses();
+    static std::vector<unsigned> getHistogram();
+    // human-readable summary, extra is appended
+    static std::string getSummary(const std::string& extra="");
+    // writes summary and all kept frames as CSV
+    static bool exportTo(const std::string& filename, const std::string& extra="");
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static std::vector<Frame> _frames; // ring buffer
+    static size_t _nextFrame;
+    static Frame _current;
+    static Section _section;
+    static clock::time_point _sectionStart;
+    static clock::time_point _frameStart;
+
+    static void switchSection(Section section);
+};
+
+#endif // _CORE_PERFSTATS_H
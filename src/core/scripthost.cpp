@@ -2,6 +2,7 @@
 #include "../luaglue/luamethod.h"
 #include <stdio.h>
 #include "gameinfo.h"
+#include "perfstats.h"
 
 
 #ifdef DEBUG_TRACKER
@@ -78,6 +79,7 @@ ScriptHost::ScriptHost(Pack* pack, lua_State *L, Tracker *tracker)
                 }
 #endif
                 w.data = newData;
+                PerfStats::Timer timer(PerfStats::Section::LUA);
                 lua_rawgeti(_L, LUA_REGISTRYINDEX, w.callback);
                 _autoTracker->Lua_Push(_L); // arg1: autotracker ("segment")
                 if (lua_pcall(_L, 1, 0, 0)) {
@@ -103,6 +105,7 @@ ScriptHost::ScriptHost(Pack* pack, lua_State *L, Tracker *tracker)
                     watchVars.push_back(varName);
             }
             if (!watchVars.empty()) {
+                PerfStats::Timer timer(PerfStats::Section::LUA);
                 lua_rawgeti(_L, LUA_REGISTRYINDEX, pair.second.callback);
                 _autoTracker->Lua_Push(_L); // arg1: autotracker ("segment")
                 json j = watchVars;
@@ -132,6 +135,7 @@ ScriptHost::ScriptHost(Pack* pack, lua_State *L, Tracker *tracker)
             if (item.canProvideCode(pair.second.code)) {
                 printf("Item %s changed, which can provide code \"%s\" for watch \"%s\"\n",
                         id.c_str(), pair.second.code.c_str(), pair.first.c_str());
+                PerfStats::Timer timer(PerfStats::Section::LUA);
                 lua_rawgeti(_L, LUA_REGISTRYINDEX, pair.second.callback);
                 lua_pushstring(_L, pair.second.code.c_str()); // arg1: code
                 if (lua_pcall(_L, 1, 0, 0)) {
@@ -370,6 +374,7 @@ bool ScriptHost::autoTrack()
 {
     // This is called every frame to run auto-tracking
     // returns true if auto-tracking changed stuff, false otherwise
+    PerfStats::Timer timer(PerfStats::Section::AUTOTRACKER);
     if (_autoTracker) return _autoTracker->doStuff();
     return false;
 }
@@ -4,6 +4,7 @@
 #include <nlohmann/json.hpp>
 #include "jsonutil.h"
 #include "util.h"
+#include "locationstates.h"
 using nlohmann::json;
 
 const LuaInterface<Tracker>::MethodMap Tracker::Lua_Methods = {
@@ -25,10 +26,14 @@ static LocationSection blankLocationSection;// = LocationSection::FromJSON(json(
 Tracker::Tracker(Pack* pack, lua_State *L)
     : _pack(pack), _L(L)
 {
+    // created first, so states are up to date before any view gets notified
+    _locationStates = new LocationStates(this);
 }
 
 Tracker::~Tracker()
 {
+    delete _locationStates;
+    _locationStates = nullptr;
 }
 
 bool Tracker::AddItems(const std::string& file) {
@@ -272,8 +277,11 @@ bool Tracker::AddLayouts(const std::string& file) {
         _layouts[key] = LayoutNode::FromJSON(value);
     }
     
-    // TODO: fire for each named layout
-    onLayoutChanged.emit(this, ""); // TODO: differentiate between structure and content
+    // fire for each named layout, so views only update what changed
+    for (auto& [key,value] : j.items()) {
+        if (value.type() == json::value_t::object)
+            onLayoutChanged.emit(this, key);
+    }
     return false;
 }
 int Tracker::ProviderCountForCode(const std::string& code)
@@ -489,6 +497,11 @@ const Pack* Tracker::getPack() const
     return _pack;
 }
 
+LocationStates* Tracker::getLocationStates()
+{
+    return _locationStates;
+}
+
 bool Tracker::changeItemState(const std::string& id, BaseItem::Action action)
 {
     std::string baseCode; // for type: toggle_badged
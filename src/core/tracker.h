@@ -18,6 +18,7 @@
 
 
 class Tracker;
+class LocationStates;
     
 class Tracker final : public LuaInterface<Tracker> {
     friend class LuaInterface;
@@ -83,6 +84,7 @@ public:
     bool isVisible(const Location& location);
 
     const Pack* getPack() const;
+    LocationStates* getLocationStates();
 
     bool changeItemState(const std::string& id, BaseItem::Action action);
 
@@ -101,6 +103,7 @@ protected:
     std::map<std::string, int> _providerCountCache;
     std::list<std::string> _bulkItemUpdates;
     bool _bulkUpdate = false;
+    LocationStates* _locationStates = nullptr;
 
     std::list<std::string>* _parents = nullptr;
     
@@ -5,9 +5,12 @@ extern "C" {
 #include <lauxlib.h>
 }
 #include <SDL2/SDL_image.h>
+#include <time.h>
 #include "ui/trackerwindow.h"
 #include "ui/broadcastwindow.h"
 #include "uilib/dlg.h"
+#include "uilib/imagecache.h"
+#include "uilib/texturestats.h"
 #include "core/luaitem.h"
 #include "core/imagereference.h"
 #include "core/fileutil.h"
@@ -15,6 +18,7 @@ extern "C" {
 #include "core/jsonutil.h"
 #include "core/statemanager.h"
 #include "core/log.h"
+#include "core/perfstats.h"
 #include "http/http.h"
 #include "ap/archipelago.h"
 #include "luaglue/luaenum.h"
@@ -31,6 +35,8 @@ enum HotkeyID {
     HOTKEY_RELOAD,
     HOTKEY_FORCE_RELOAD,
     HOTKEY_TOGGLE_SPLIT_COLORS,
+    HOTKEY_TOGGLE_PERF_HUD,
+    HOTKEY_EXPORT_PERF_STATS,
 };
 
 
@@ -141,6 +147,15 @@ PopTracker::PopTracker(int argc, char** argv, bool cli, const json& args)
     if (!_config["software_fps_limit"].is_number())
         _config["software_fps_limit"] = DEFAULT_SOFTWARE_FPS_LIMIT;
 
+    if (!_config["broadcast_fps_limit"].is_number())
+        _config["broadcast_fps_limit"] = DEFAULT_BROADCAST_FPS_LIMIT;
+
+    if (!_config["image_cache_size"].is_number())
+        _config["image_cache_size"] = 0; // MiB, 0 = disabled
+
+    if (!_config["texture_budget"].is_number())
+        _config["texture_budget"] = 0; // MiB, 0 = unlimited
+
     if (_config["export_file"].is_string() && _config["export_uid"].is_string()) {
         _exportFile = _config["export_file"];
         _exportUID = _config["export_uid"];
@@ -199,6 +214,17 @@ PopTracker::PopTracker(int argc, char** argv, bool cli, const json& args)
     // NOTE: signals are connected later to allow gui and non-gui interaction
 
     StateManager::setDir(getConfigPath(APPNAME, "saves", _isPortable));
+
+#ifndef __EMSCRIPTEN__ // no persistent storage
+    int imageCacheSize = _config["image_cache_size"].get<int>();
+    if (imageCacheSize > 0)
+        Ui::ImageCache::setDir(getConfigPath(APPNAME, "image-cache", _isPortable),
+                (size_t)imageCacheSize * 1024 * 1024);
+#endif
+
+    int textureBudget = _config["texture_budget"].get<int>();
+    if (textureBudget > 0)
+        Ui::TextureStats::setBudget((size_t)textureBudget * 1024 * 1024);
 }
 
 PopTracker::~PopTracker()
@@ -309,6 +335,30 @@ bool PopTracker::start()
             Ui::MapWidget::SplitRects = !Ui::MapWidget::SplitRects;
             _config["split_map_locations"] = Ui::MapWidget::SplitRects;
         }
+        else if (hotkey.id == HOTKEY_TOGGLE_PERF_HUD) {
+            if (_win) _win->setPerfHudVisible(!_win->getPerfHudVisible());
+        }
+        else if (hotkey.id == HOTKEY_EXPORT_PERF_STATS) {
+            char name[64];
+            time_t t = time(nullptr);
+            strftime(name, sizeof(name), "perf-%Y%m%d-%H%M%S.txt", localtime(&t));
+            std::string filename = getConfigPath(APPNAME, name, _isPortable);
+            char buf[128];
+            snprintf(buf, sizeof(buf), "textures: %u, ~%u KiB, budget %u KiB\n",
+                    (unsigned)Ui::TextureStats::getCount(), (unsigned)(Ui::TextureStats::getBytes()/1024),
+                    (unsigned)(Ui::TextureStats::getBudget()/1024));
+            std::string extra = buf;
+            if (_win) {
+                snprintf(buf, sizeof(buf), "  main window: ~%u KiB\n", (unsigned)(_win->getTextureBytes()/1024));
+                extra += buf;
+            }
+            if (_broadcast) {
+                snprintf(buf, sizeof(buf), "  broadcast: ~%u KiB\n", (unsigned)(_broadcast->getTextureBytes()/1024));
+                extra += buf;
+            }
+            if (PerfStats::exportTo(filename, extra))
+                printf("Performance data written to %s\n", filename.c_str());
+        }
     }};
     _ui->addHotkey({HOTKEY_TOGGLE_VISIBILITY, SDLK_F11, KMOD_NONE});
     _ui->addHotkey({HOTKEY_TOGGLE_VISIBILITY, SDLK_h, KMOD_LCTRL});
@@ -322,6 +372,9 @@ bool PopTracker::start()
     _ui->addHotkey({HOTKEY_RELOAD, SDLK_r, KMOD_RCTRL});
     _ui->addHotkey({HOTKEY_TOGGLE_SPLIT_COLORS, SDLK_p, KMOD_LCTRL});
     _ui->addHotkey({HOTKEY_TOGGLE_SPLIT_COLORS, SDLK_p, KMOD_RCTRL});
+    _ui->addHotkey({HOTKEY_TOGGLE_PERF_HUD, SDLK_F3, KMOD_NONE});
+    _ui->addHotkey({HOTKEY_EXPORT_PERF_STATS, SDLK_F3, KMOD_LCTRL});
+    _ui->addHotkey({HOTKEY_EXPORT_PERF_STATS, SDLK_F3, KMOD_RCTRL});
 
     // restore state from config
     if (_config.type() == json::value_t::object) {
@@ -392,6 +445,7 @@ bool PopTracker::start()
                 Ui::Position pos = _win->getPosition() + Ui::Size{0,32};
                 _broadcast = _ui->createWindow<Ui::BroadcastWindow>("Broadcast", icon, pos);
                 SDL_FreeSurface(icon);
+                _broadcast->setFPSLimit(_config["broadcast_fps_limit"].get<unsigned>());
                 // set user preferences for visibility of uncleared and unreachable locations
                 auto itHideCleared = _config.find("hide_cleared_locations");
                 auto itHideUnreachable = _config.find("hide_unreachable_locations");
@@ -692,6 +746,7 @@ bool PopTracker::start()
 bool PopTracker::frame()
 {
     if (_asio) {
+        PerfStats::Timer timer(PerfStats::Section::ASIO);
         _asio->poll();
         // when all tasks are done, poll() will stop(). Reset for next request.
         if (_asio->stopped()) _asio->restart();
@@ -710,7 +765,7 @@ bool PopTracker::frame()
     td = std::chrono::duration_cast<std::chrono::milliseconds>(now - _fpsTimer).count();
     if (td >= 5000) {
         unsigned f = _frames*1000; f/=td;
-        printf("FPS:%4u (max %2dms)\n", f, _maxFrameTime);
+        printf("FPS:%4u (max %2dms, max %u layout passes)\n", f, _maxFrameTime, (unsigned)PerfStats::getMaxLayoutPasses());
         _frames = 0;
         _fpsTimer = now;
         _maxFrameTime = 0;
@@ -718,6 +773,12 @@ bool PopTracker::frame()
 #endif
     _frames++;
     bool res = _ui->render();
+    PerfStats::endFrame();
+    if (res && _win && _win->getPerfHudVisible() &&
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - _perfHudTimer).count() >= 500) {
+        _win->updatePerfHud();
+        _perfHudTimer = now;
+    }
     
     if (!res) {
         // application is going to exit
@@ -904,6 +965,7 @@ void PopTracker::unloadTracker()
     _scriptHost = nullptr;
     _pack = nullptr;
     _archipelago = nullptr;
+    Ui::ImageFilter::clearCache(); // decoded overlays of the old pack
 }
 
 bool PopTracker::loadTracker(const std::string& pack, const std::string& variant, bool loadAutosave)
@@ -53,6 +53,7 @@ private:
     unsigned _maxFrameTime = 0;
     std::chrono::steady_clock::time_point _fpsTimer;
     std::chrono::steady_clock::time_point _frameTimer;
+    std::chrono::steady_clock::time_point _perfHudTimer;
     
     std::string _newPack;
     std::string _newVariant;
@@ -1,6 +1,7 @@
 #include "defaulttrackerwindow.h"
 #include "../uilib/hbox.h"
 #include "../core/assets.h"
+#include "defaults.h" // DEFAULT_FONT_*
 
 namespace Ui {
 
@@ -122,6 +123,8 @@ DefaultTrackerWindow::~DefaultTrackerWindow()
     _lblProgressPercent = nullptr;
     _lblProgressValues = nullptr;
     _pgbProgress = nullptr;
+    delete _perfHud;
+    _perfHud = nullptr;
 }
 
 void DefaultTrackerWindow::setTracker(Tracker* tracker)
@@ -186,6 +189,24 @@ void DefaultTrackerWindow::render(Renderer renderer, int offX, int offY)
             setTracker(tracker); // reevaluate preferred and fall-back layout
     }
     TrackerWindow::render(renderer, offX, offY);
+    if (_perfHud) _perfHud->render(renderer, offX, offY);
+}
+
+void DefaultTrackerWindow::setPerfHudVisible(bool visible)
+{
+    if (visible == (_perfHud != nullptr)) return;
+    if (visible) {
+        int top = _menu ? _menu->getTop() + _menu->getHeight() : 0;
+        _perfHud = new PerfHud(2, top + 2, _fontStore->getFont(DEFAULT_FONT_NAME, DEFAULT_FONT_SIZE - 2));
+    } else {
+        delete _perfHud;
+        _perfHud = nullptr;
+    }
+}
+
+void DefaultTrackerWindow::updatePerfHud()
+{
+    if (_perfHud) _perfHud->update();
 }
 
 void DefaultTrackerWindow::setAutoTrackerState(int index, AutoTracker::State state, const std::string& name, const std::string& subname)
@@ -3,6 +3,7 @@
 
 #include "trackerwindow.h"
 #include "loadpackwidget.h"
+#include "perfhud.h"
 #include "../uilib/progressbar.h"
 #include <vector>
 
@@ -23,6 +24,9 @@ public:
     virtual void hideOpen();
     virtual void showProgress(const std::string& title, int progress, int max);
     virtual void hideProgress();
+    void setPerfHudVisible(bool visible);
+    bool getPerfHudVisible() const { return _perfHud != nullptr; }
+    void updatePerfHud();
     
     Signal<const std::string&,const std::string&> onPackSelected;
     
@@ -43,6 +47,7 @@ protected:
     Label *_lblProgressPercent = nullptr;
     Label *_lblProgressValues = nullptr;
     ProgressBar *_pgbProgress = nullptr;
+    PerfHud *_perfHud = nullptr; // drawn on top, not a child so it does not take input
     std::vector<AutoTracker::State> _autoTrackerStates;
     std::vector<std::string> _autoTrackerNames;
     std::vector<std::string> _autoTrackerSubNames;
@@ -1,8 +1,9 @@
 #include "item.h"
 #include <stdio.h>
 #include <SDL2/SDL_image.h>
-#include "../uilib/colorhelper.h"
 #include "../uilib/textutil.h"
+#include "../uilib/imagedecoder.h"
+#include "../uilib/texturestats.h"
 
 
 namespace Ui {
@@ -15,14 +16,26 @@ Item::Item(int x, int y, int w, int h, FONT font)
 
 Item::~Item()
 {
-    for (auto& texset : _texs) for (auto& tex : texset) if (tex) SDL_DestroyTexture(tex);
+    for (auto& texset : _texs) for (auto& tex : texset) if (tex) TextureStats::destroy(tex);
     for (auto& surfset : _surfs) for (auto& surf : surfset) if (surf) SDL_FreeSurface(surf);
 }
 
 void Item::setStage(int stage1, int stage2)
 {
+    if ((stage1<0 || stage1==_stage1) && (stage2<0 || stage2==_stage2)) return;
     if (stage1>=0) _stage1 = stage1;
     if (stage2>=0) _stage2 = stage2;
+    invalidate();
+}
+
+bool Item::isRenderCacheable() const
+{
+    // render() picks up the image and calls invalidate() once it is ready
+    if (_stage1 < (int)_jobs.size() && _stage2 < (int)_jobs[_stage1].size() && _jobs[_stage1][_stage2])
+        return false;
+    if (_stage1 < (int)_loaders.size() && _stage2 < (int)_loaders[_stage1].size() && _loaders[_stage1][_stage2])
+        return false;
+    return true;
 }
 
 void Item::freeStage(int stage1, int stage2)
@@ -32,39 +45,58 @@ void Item::freeStage(int stage1, int stage2)
         _surfs[stage1][stage2] = nullptr;
     }
     if ((int)_texs.size() > stage1 && (int)_texs[stage1].size() > stage2) {
-        SDL_DestroyTexture(_texs[stage1][stage2]);
+        TextureStats::destroy(_texs[stage1][stage2]);
         _texs[stage1][stage2] = nullptr;
     }
+    if ((int)_data.size() > stage1 && (int)_data[stage1].size() > stage2) {
+        _data[stage1][stage2].clear();
+    }
     if ((int)_names.size() > stage1 && (int)_names[stage1].size() > stage2) {
         _names[stage1][stage2].clear();
     }
     if ((int)_filters.size() > stage1 && (int)_filters[stage1].size() > stage2) {
         _filters[stage1][stage2].clear();
     }
+    if ((int)_jobs.size() > stage1 && (int)_jobs[stage1].size() > stage2 && _jobs[stage1][stage2]) {
+        _jobs[stage1][stage2] = nullptr; // a running job will be dropped by the decoder
+        _pendingJobs--;
+    }
+    if ((int)_loaders.size() > stage1 && (int)_loaders[stage1].size() > stage2) {
+        _loaders[stage1][stage2] = nullptr;
+    }
+    if ((int)_sizes.size() > stage1 && (int)_sizes[stage1].size() > stage2) {
+        _sizes[stage1][stage2] = {0,0};
+    }
+    if (stage1 == _stage1 && stage2 == _stage2) invalidate();
 }
 
-void Item::addStage(int stage1, int stage2, SDL_Surface* surf, const std::string& name, std::list<ImageFilter> filters)
+void Item::reserveStage(int stage1, int stage2)
 {
-    if (!surf) return;
-    // if any corner pixel is #ff00ff, make that color transparent
-    surf = makeTransparent(surf, 0xff, 0x00, 0xff, filters.empty());
-    // if filters have an overlay, we need an RGB(A) surface
-    bool needsRGB = false;
-    for (auto& filter: filters) {
-        if (filter.name == "overlay") {
-            needsRGB = true;
-            break;
-        }
+    while ((int)_surfs.size() <= stage1) {
+        _surfs.push_back({});
+        _names.push_back({});
+        _filters.push_back({});
+        _jobs.push_back({});
+        _data.push_back({});
+        _loaders.push_back({});
+        _sizes.push_back({});
     }
-    if (needsRGB && surf->format->BitsPerPixel < 32) {
-        auto old = surf;
-        surf = SDL_ConvertSurfaceFormat(old, SDL_PIXELFORMAT_ARGB8888, 0);
-        SDL_FreeSurface(old);
-        if (!surf) return;
+    while ((int)_surfs[stage1].size() <= stage2) {
+        _surfs[stage1].push_back(nullptr);
+        _names[stage1].push_back("");
+        _filters[stage1].push_back({});
+        _jobs[stage1].push_back(nullptr);
+        _data[stage1].push_back("");
+        _loaders[stage1].push_back(nullptr);
+        _sizes[stage1].push_back({0,0});
     }
-    // store size
-    if (_autoSize.width  < surf->w) _autoSize.width  = surf->w;
-    if (_autoSize.height < surf->h) _autoSize.height = surf->h;
+}
+
+void Item::storeSize(int stage1, int stage2, int w, int h)
+{
+    _sizes[stage1][stage2] = {w, h};
+    if (_autoSize.width  < w) _autoSize.width  = w;
+    if (_autoSize.height < h) _autoSize.height = h;
     if (_size.width<1 && _size.height<1) {
         _size.width = _autoSize.width;
         _size.height = _autoSize.height;
@@ -73,21 +105,80 @@ void Item::addStage(int stage1, int stage2, SDL_Surface* surf, const std::string
     } else if (_size.height<1) {
         _size.height = (_autoSize.height * _size.width + _autoSize.width/2) / _autoSize.width;
     }
-    while ((int)_surfs.size() <= stage1) {
-        _surfs.push_back({});
-        _names.push_back({});
-        _filters.push_back({});
-    }
-    while ((int)_surfs[stage1].size() <= stage2) {
-        _surfs[stage1].push_back(nullptr);
-        _names[stage1].push_back("");
-        _filters[stage1].push_back({});
+}
+
+void Item::storeStage(int stage1, int stage2, SDL_Surface* surf)
+{
+    storeSize(stage1, stage2, surf->w, surf->h);
+    // replace the image that was shown while decoding, see addStage()
+    if ((int)_texs.size() > stage1 && (int)_texs[stage1].size() > stage2 && _texs[stage1][stage2]) {
+        TextureStats::destroy(_texs[stage1][stage2]);
+        _texs[stage1][stage2] = nullptr;
     }
-    // apply filters
-    for (auto filter: filters)
-        surf = filter.apply(surf);
     // store final surface
     _surfs[stage1][stage2] = surf;
+    if (stage1 == _stage1 && stage2 == _stage2) invalidate();
+}
+
+void Item::finishStage(int stage1, int stage2, bool wait)
+{
+    if ((int)_jobs.size() <= stage1 || (int)_jobs[stage1].size() <= stage2)
+        return;
+    auto& job = _jobs[stage1][stage2];
+    if (!job || (!wait && !job->isDone()))
+        return;
+    auto surf = job->take();
+    job = nullptr;
+    _pendingJobs--;
+    if (!surf) {
+        // decoding failed, don't retry in render()
+        _names[stage1][stage2].clear();
+        _filters[stage1][stage2].clear();
+        _data[stage1][stage2].clear();
+        return;
+    }
+    storeStage(stage1, stage2, surf);
+}
+
+void Item::loadStage(int stage1, int stage2)
+{
+    if (stage1 < 0 || stage2 < 0 || (int)_loaders.size() <= stage1 || (int)_loaders[stage1].size() <= stage2)
+        return;
+    if (!_loaders[stage1][stage2])
+        return;
+    // the loader calls addStage, which resets the loader
+    auto loader = std::move(_loaders[stage1][stage2]);
+    _loaders[stage1][stage2] = nullptr;
+    loader();
+}
+
+void Item::waitForSize()
+{
+    // auto size covers all stages, so it does not change when switching stages.
+    // images without size from the header have to be loaded and decoded here
+    for (int stage1=0; stage1<(int)_loaders.size(); stage1++)
+        for (int stage2=0; stage2<(int)_loaders[stage1].size(); stage2++)
+            if (_sizes[stage1][stage2].width < 1) loadStage(stage1, stage2);
+    for (int stage1=0; _pendingJobs && stage1<(int)_jobs.size(); stage1++)
+        for (int stage2=0; _pendingJobs && stage2<(int)_jobs[stage1].size(); stage2++)
+            if (_sizes[stage1][stage2].width < 1) finishStage(stage1, stage2, true);
+}
+
+void Item::waitForStages()
+{
+    loadStage(_stage1, _stage2);
+    for (int stage1=0; _pendingJobs && stage1<(int)_jobs.size(); stage1++)
+        for (int stage2=0; _pendingJobs && stage2<(int)_jobs[stage1].size(); stage2++)
+            finishStage(stage1, stage2, true);
+}
+
+void Item::addStage(int stage1, int stage2, SDL_Surface* surf, const std::string& name, std::list<ImageFilter> filters)
+{
+    // make transparent, apply filters
+    surf = ImageDecoder::process(surf, filters);
+    if (!surf) return;
+    reserveStage(stage1, stage2);
+    storeStage(stage1, stage2, surf);
     _names[stage1][stage2] = name;
     _filters[stage1][stage2] = filters;
 }
@@ -96,7 +187,6 @@ void Item::addStage(int stage1, int stage2, const char *path, std::list<ImageFil
 {
     freeStage(stage1, stage2);
     if (!path || !*path) return;
-    // FIXME: loading images takes a majority of the time to build the UI. Cache it!
     auto surf = IMG_Load(path);
     if (surf) {
         addStage(stage1, stage2, surf, path, filters);
@@ -109,16 +199,40 @@ void Item::addStage(int stage1, int stage2, const char *path, std::list<ImageFil
 void Item::addStage(int stage1, int stage2, const void *data, size_t len, const std::string& name,
                     std::list<ImageFilter> filters)
 {
-    freeStage(stage1, stage2);
-    if (!data || !len) return;
-    // FIXME: loading images takes a majority of the time to build the UI. Cache it!
-    auto surf = IMG_Load_RW(SDL_RWFromMem((void*)data, (int)len), 1);
-    if (surf) {
-        addStage(stage1, stage2, surf, name, filters);
+    // keep showing the old image until the new one is decoded, see storeStage()
+    SDL_Texture* oldTex = nullptr;
+    if ((int)_texs.size() > stage1 && (int)_texs[stage1].size() > stage2) {
+        oldTex = _texs[stage1][stage2];
+        _texs[stage1][stage2] = nullptr;
     }
-    else {
-        fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
+    freeStage(stage1, stage2);
+    if (!data || !len) {
+        if (oldTex) TextureStats::destroy(oldTex);
+        return;
     }
+    // decode in the background, the stage is finished in render() or waitForStages()
+    reserveStage(stage1, stage2);
+    _names[stage1][stage2] = name;
+    _filters[stage1][stage2] = filters;
+    _data[stage1][stage2].assign((const char*)data, len);
+    _jobs[stage1][stage2] = ImageDecoder::submit(_data[stage1][stage2], std::move(filters));
+    _pendingJobs++;
+    if (oldTex) _texs[stage1][stage2] = oldTex;
+    // auto size is known before decoding for PNGs
+    int w, h;
+    if (ImageDecoder::getSize(_data[stage1][stage2], w, h))
+        storeSize(stage1, stage2, w, h);
+}
+
+void Item::addLazyStage(int stage1, int stage2, stage_loader loader, Size size)
+{
+    freeStage(stage1, stage2);
+    if (!loader) return;
+    reserveStage(stage1, stage2);
+    _loaders[stage1][stage2] = std::move(loader);
+    if (size.width > 0 && size.height > 0)
+        storeSize(stage1, stage2, size.width, size.height);
+    if (stage1 == _stage1 && stage2 == _stage2) invalidate();
 }
 
 bool Item::isStage(int stage1, int stage2, const std::string& name, std::list<ImageFilter> filters)
@@ -141,8 +255,26 @@ void Item::render(Renderer renderer, int offX, int offY)
         };
         SDL_RenderFillRect(renderer, &r);
     }
+    loadStage(_stage1, _stage2);
+    if (_pendingJobs) {
+        // pick up images that finished decoding, a stage shows nothing (or its
+        // previous image, see addStage()) until its image is ready
+        for (int stage1=0; stage1<(int)_jobs.size(); stage1++)
+            for (int stage2=0; stage2<(int)_jobs[stage1].size(); stage2++)
+                finishStage(stage1, stage2, false);
+    }
     auto tex  = (_stage1<(int)_texs.size() && _stage2<(int)_texs[_stage1].size()) ? _texs[_stage1][_stage2] : nullptr;
     auto surf = (!tex && _stage1<(int)_surfs.size() && _stage2<(int)_surfs[_stage1].size()) ? _surfs[_stage1][_stage2] : nullptr;
+    if (!tex && !surf && _stage1<(int)_data.size() && _stage2<(int)_data[_stage1].size() &&
+            !_data[_stage1][_stage2].empty() && !_jobs[_stage1][_stage2]) {
+        // texture was evicted, decode again in the background (from ImageCache
+        // if enabled), nothing is shown until finishStage() picks it up
+        _jobs[_stage1][_stage2] = ImageDecoder::submit(_data[_stage1][_stage2], _filters[_stage1][_stage2]);
+        _pendingJobs++;
+        finishStage(_stage1, _stage2, false); // done already without threads
+        surf = _surfs[_stage1][_stage2];
+        if (!surf) return;
+    }
     if (!tex && surf) {
         if (_quality >= 0) {
             // set Texture filter/quality when creating the texture
@@ -151,7 +283,11 @@ void Item::render(Renderer renderer, int offX, int offY)
                 printf("Image: could not set scale quality to %s!\n", q);
             }
         }
-        tex = SDL_CreateTextureFromSurface(renderer, surf);
+        tex = TextureStats::created(renderer, SDL_CreateTextureFromSurface(renderer, surf));
+        if (!_data[_stage1][_stage2].empty()) {
+            int stage1 = _stage1, stage2 = _stage2;
+            TextureStats::setEvictable(tex, [this, stage1, stage2]() { _texs[stage1][stage2] = nullptr; });
+        }
         SDL_FreeSurface (surf);
         _surfs[_stage1][_stage2] = nullptr;
         if (_quality >= 0) {
@@ -164,6 +300,11 @@ void Item::render(Renderer renderer, int offX, int offY)
         _texs[_stage1][_stage2] = tex;
     }
     if (!tex) return;
+    if (!_pendingJobs) {
+        // prefetch the next stage and the other state in the background
+        loadStage(_stage1, _stage2+1);
+        loadStage(_stage1 ? 0 : 1, _stage2);
+    }
     if (_fixedAspect) {
         int finalw=0, finalh=0;
         float ar = (float)_autoSize.width / (float)_autoSize.height;
@@ -187,79 +328,128 @@ void Item::render(Renderer renderer, int offX, int offY)
         _renderPos = _pos;
     }
     SDL_Rect dest = {.x = offX+_renderPos.left, .y = offY+_renderPos.top, .w = _renderSize.width, .h = _renderSize.height};
+    TextureStats::used(tex);
     SDL_RenderCopy(renderer, tex, NULL, &dest);
     if (!_overlay.empty() && _font && !_overlayTex) {
-        // text
-        SDL_Surface* tsurf = RenderText(_font, _overlay.c_str(), {
-            _overlayColor.r, _overlayColor.g, _overlayColor.b, _overlayColor.a
-        }, Label::HAlign::RIGHT);
-        // light
-        SDL_Surface* lsurf = RenderText(_font, _overlay.c_str(), {
-            255, 255, 255, 255
-        }, Label::HAlign::RIGHT);
-        SDL_SetSurfaceAlphaMod(lsurf, 96);
-        // shadow
-        SDL_Surface* ssurf = RenderText(_font, _overlay.c_str(), {
-            0, 0, 0, 255
-        }, Label::HAlign::RIGHT);
-        // combine
-        SDL_Surface* surf = nullptr;
-        if (tsurf && lsurf && ssurf) {
-            surf = SDL_CreateRGBSurfaceWithFormat(0, tsurf->w+2, tsurf->h+2, tsurf->format->BitsPerPixel, tsurf->format->format);
+        if (!_overlayGlyphsValid || _overlayAtlasRenderer != renderer ||
+                _overlayAtlasGeneration != GlyphAtlas::getGeneration()) {
+            // decided once per overlay, font and renderer, see Label::render()
+            _overlayAtlas = GlyphAtlas::canRender(_overlay) ? GlyphAtlas::get(renderer, _font) : nullptr;
+            _overlayAtlasRenderer = renderer;
+            _overlayAtlasGeneration = GlyphAtlas::getGeneration();
+            if (_overlayAtlas)
+                _overlayGlyphsSize = _overlayAtlas->layout(_overlay, Label::HAlign::RIGHT, _overlayGlyphs);
+            _overlayGlyphsValid = true;
+        }
+        if (!_overlayAtlas) {
+            // text
+            SDL_Surface* tsurf = RenderText(_font, _overlay.c_str(), {
+                _overlayColor.r, _overlayColor.g, _overlayColor.b, _overlayColor.a
+            }, Label::HAlign::RIGHT);
+            // light
+            SDL_Surface* lsurf = RenderText(_font, _overlay.c_str(), {
+                255, 255, 255, 255
+            }, Label::HAlign::RIGHT);
+            SDL_SetSurfaceAlphaMod(lsurf, 96);
+            // shadow
+            SDL_Surface* ssurf = RenderText(_font, _overlay.c_str(), {
+                0, 0, 0, 255
+            }, Label::HAlign::RIGHT);
+            // combine
+            SDL_Surface* surf = nullptr;
+            if (tsurf && lsurf && ssurf) {
+                surf = SDL_CreateRGBSurfaceWithFormat(0, tsurf->w+2, tsurf->h+2, tsurf->format->BitsPerPixel, tsurf->format->format);
+                if (surf) {
+                    SDL_Rect d = { .x=0, .y=0, .w=tsurf->w, .h=tsurf->h };
+                    if (_overlayBackgroundColor.a)
+                        SDL_FillRect(lsurf, &d, SDL_MapRGBA(lsurf->format,
+                                _overlayBackgroundColor.r, _overlayBackgroundColor.g,
+                                _overlayBackgroundColor.b, _overlayBackgroundColor.a
+                        ));
+                    SDL_BlitSurface(lsurf, NULL, surf, &d);
+                    SDL_SetSurfaceAlphaMod(lsurf, 128);
+                    d.x=1; d.y=0;
+                    SDL_BlitSurface(lsurf, NULL, surf, &d);
+                    d.x=0; d.y=1;
+                    SDL_BlitSurface(lsurf, NULL, surf, &d);
+                    d.x=2; d.y=2;
+                    SDL_BlitSurface(ssurf, NULL, surf, &d);
+                    d.x=1; d.y=1;
+                    SDL_BlitSurface(tsurf, NULL, surf, &d);
+                }
+            }
+            if (tsurf) SDL_FreeSurface(tsurf);
+            if (ssurf) SDL_FreeSurface(ssurf);
+            if (lsurf) SDL_FreeSurface(lsurf);
             if (surf) {
-                SDL_Rect d = { .x=0, .y=0, .w=tsurf->w, .h=tsurf->h };
-                if (_overlayBackgroundColor.a)
-                    SDL_FillRect(lsurf, &d, SDL_MapRGBA(lsurf->format,
-                            _overlayBackgroundColor.r, _overlayBackgroundColor.g,
-                            _overlayBackgroundColor.b, _overlayBackgroundColor.a
-                    ));
-                SDL_BlitSurface(lsurf, NULL, surf, &d);
-                SDL_SetSurfaceAlphaMod(lsurf, 128);
-                d.x=1; d.y=0;
-                SDL_BlitSurface(lsurf, NULL, surf, &d);
-                d.x=0; d.y=1;
-                SDL_BlitSurface(lsurf, NULL, surf, &d);
-                d.x=2; d.y=2;
-                SDL_BlitSurface(ssurf, NULL, surf, &d);
-                d.x=1; d.y=1;
-                SDL_BlitSurface(tsurf, NULL, surf, &d);
+                _overlayTex = TextureStats::created(renderer, SDL_CreateTextureFromSurface(renderer, surf));
+                SDL_FreeSurface(surf);
+            } else {
+                printf("Text render error: %s\n", TTF_GetError());
             }
         }
-        if (tsurf) SDL_FreeSurface(tsurf);
-        if (ssurf) SDL_FreeSurface(ssurf);
-        if (lsurf) SDL_FreeSurface(lsurf);
-        if (surf) {
-            _overlayTex = SDL_CreateTextureFromSurface(renderer, surf);
-            SDL_FreeSurface(surf);
-        } else {
-            printf("Text render error: %s\n", TTF_GetError());
-        }
     }
-    if (_overlayTex) {
+    GlyphAtlas* atlas = (_overlayGlyphsValid && !_overlay.empty() && _font) ? _overlayAtlas : nullptr;
+    if (_overlayTex || atlas) {
         int ow=0,oh=0; // TODO: cache instead
-        if (SDL_QueryTexture(_overlayTex, NULL, NULL, &ow, &oh) == 0) {
-            SDL_Rect dest;
-            int bottom = offY+_pos.top+_size.height-1;
-            if (ow>_size.width) {
-                int center = offX+_pos.left+_size.width/2;
-                dest = {
-                    .x = center-ow/2,
-                    .y = bottom-oh,
-                    .w = ow,
-                    .h = oh
-                };
-            } else {
-                int right = offX+_pos.left+_size.width-1;
-                dest = {
-                    .x = right-ow,
-                    .y = bottom-oh,
-                    .w = ow,
-                    .h = oh
-                };
-            }
-            SDL_RenderCopy(renderer, _overlayTex, NULL, &dest);
+        if (atlas) {
+            // +2 for light and shadow, see drawOverlayGlyphs()
+            ow = _overlayGlyphsSize.width + 2;
+            oh = _overlayGlyphsSize.height + 2;
+        } else if (SDL_QueryTexture(_overlayTex, NULL, NULL, &ow, &oh) != 0) {
+            return;
         }
+        SDL_Rect dest;
+        int bottom = offY+_pos.top+_size.height-1;
+        if (ow>_size.width) {
+            int center = offX+_pos.left+_size.width/2;
+            dest = {
+                .x = center-ow/2,
+                .y = bottom-oh,
+                .w = ow,
+                .h = oh
+            };
+        } else {
+            int right = offX+_pos.left+_size.width-1;
+            dest = {
+                .x = right-ow,
+                .y = bottom-oh,
+                .w = ow,
+                .h = oh
+            };
+        }
+        if (atlas)
+            drawOverlayGlyphs(renderer, atlas, dest.x, dest.y);
+        else
+            SDL_RenderCopy(renderer, _overlayTex, NULL, &dest);
+    }
+}
+
+void Item::drawOverlayGlyphs(Renderer renderer, GlyphAtlas* atlas, int x, int y)
+{
+    // same result as the surface that is combined in render()
+    int w = _overlayGlyphsSize.width;
+    int h = _overlayGlyphsSize.height;
+    // light or background
+    if (_overlayBackgroundColor.a) {
+        const auto& c = _overlayBackgroundColor;
+        SDL_Rect r = { x, y, w, h };
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, (uint8_t)(c.a*96/255));
+        SDL_RenderFillRect(renderer, &r);
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, (uint8_t)(c.a*128/255));
+        r = { x+1, y, w, h };
+        SDL_RenderFillRect(renderer, &r);
+        r = { x, y+1, w, h };
+        SDL_RenderFillRect(renderer, &r);
+    } else {
+        atlas->draw(_overlayGlyphs, x, y, {255, 255, 255, 96});
+        atlas->draw(_overlayGlyphs, x+1, y, {255, 255, 255, 128});
+        atlas->draw(_overlayGlyphs, x, y+1, {255, 255, 255, 128});
     }
+    // shadow
+    atlas->draw(_overlayGlyphs, x+2, y+2, {0, 0, 0, 255});
+    // text
+    atlas->draw(_overlayGlyphs, x+1, y+1, _overlayColor);
 }
 
 void Item::setSize(Size size) {
@@ -272,31 +462,39 @@ void Item::setSize(Size size) {
 
 void Item::setFont(Item::FONT font) {
     if (_font == font) return;
-    if (_overlayTex) SDL_DestroyTexture(_overlayTex);
+    if (_overlayTex) TextureStats::destroy(_overlayTex);
     _overlayTex = nullptr;
+    _overlayGlyphsValid = false;
+    _overlayAtlas = nullptr;
     _font = font;
+    invalidate();
 }
 
 void Item::setOverlay(const std::string& s) {
     if (s == _overlay) return;
-    if (_overlayTex) SDL_DestroyTexture(_overlayTex);
+    if (_overlayTex) TextureStats::destroy(_overlayTex);
     _overlayTex = nullptr;
+    _overlayGlyphsValid = false;
+    _overlayAtlas = nullptr;
     _overlay = s;
+    invalidate();
 }
 
 void Item::setOverlayColor(Widget::Color c) {
     if (c == _overlayColor) return;
-    if (_overlayTex) SDL_DestroyTexture(_overlayTex);
+    if (_overlayTex) TextureStats::destroy(_overlayTex);
     _overlayTex = nullptr;
     _overlayColor = c;
+    invalidate();
 }
 
 void Item::setOverlayBackgroundColor(Widget::Color c)
 {
     if (c == _overlayBackgroundColor) return;
-    if (_overlayTex) SDL_DestroyTexture(_overlayTex);
+    if (_overlayTex) TextureStats::destroy(_overlayTex);
     _overlayTex = nullptr;
     _overlayBackgroundColor = c;
+    invalidate();
 }
 
 } // namespace
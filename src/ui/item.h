@@ -3,10 +3,13 @@
 
 #include "../uilib/widget.h"
 #include "../uilib/imagefilter.h"
+#include "../uilib/imagedecoder.h"
 #include <vector>
 #include <list>
+#include <functional>
 #include <SDL2/SDL_ttf.h>
 #include "../uilib/label.h"
+#include "../uilib/glyphatlas.h"
 
 namespace Ui {
 
@@ -14,14 +17,18 @@ class Item : public Widget
 {
 public:
     using FONT = TTF_Font*;
+    // loads a stage on first use by calling addStage()
+    typedef std::function<void(void)> stage_loader;
     Item(int x, int y, int w, int h, FONT font);
     ~Item();
     virtual void render(Renderer renderer, int offX, int offY) override;
     virtual void setSize(Size size) override;
+    // not cacheable while the current stage's image is still being loaded
+    virtual bool isRenderCacheable() const override;
     virtual void setFont(FONT font);
     int getQuality() const { return _quality; }
     // NOTE: this has to be set before the image is rendered for the first time
-    virtual void setQuality(int q) { _quality = q; }
+    virtual void setQuality(int q) { _quality = q; invalidate(); }
     
     virtual void setStage(int stage1, int stage2);
     virtual int getStage1() const { return _stage1; }
@@ -30,7 +37,15 @@ public:
     virtual void addStage(int stage1, int stage2, const char *path, std::list<ImageFilter> filters={});
     virtual void addStage(int stage1, int stage2, const void *data, size_t len, const std::string& name,
                           std::list<ImageFilter> filters={});
+    // stage is loaded when it is about to be shown, the next stage is prefetched.
+    // size should be read from the image header, so auto size is known before loading
+    virtual void addLazyStage(int stage1, int stage2, stage_loader loader, Size size={0,0});
     virtual bool isStage(int stage1, int stage2, const std::string& name, std::list<ImageFilter> filters);
+    // load the current stage and block until all started images are decoded
+    void waitForStages();
+    // block until the sizes of all stages are known, this only loads stages
+    // without size from the image header. required before using auto size
+    void waitForSize();
     virtual void setOverlay(const std::string& s);
     virtual void setOverlayColor(Widget::Color color);
     virtual void setOverlayBackgroundColor(Widget::Color color);
@@ -43,6 +58,7 @@ public:
     void setImageAlignment(Label::HAlign halign, Label::VAlign valign) {
         _halign = halign;
         _valign = valign;
+        invalidate();
     }
 
 protected:
@@ -50,6 +66,11 @@ protected:
     std::vector< std::vector<SDL_Texture*> > _texs; // TODO: use texture store to avoid storing duplicates
     std::vector< std::vector<std::string> > _names;
     std::vector< std::vector<std::list<ImageFilter>> > _filters;
+    std::vector< std::vector<ImageDecoder::JobPtr> > _jobs; // images being decoded in the background
+    std::vector< std::vector<std::string> > _data; // encoded images to re-create evicted textures
+    std::vector< std::vector<stage_loader> > _loaders; // stages that were not loaded yet
+    std::vector< std::vector<Size> > _sizes; // image size per stage, 0 if not known yet
+    size_t _pendingJobs = 0;
     bool _fixedAspect=true;
     int _quality=-1;
     int _stage1=0;
@@ -60,13 +81,25 @@ protected:
     std::string _overlay;
     Widget::Color _overlayColor = {255,255,255};
     Widget::Color _overlayBackgroundColor = {};
-    SDL_Texture *_overlayTex = nullptr;
+    SDL_Texture *_overlayTex = nullptr; // only used if text can not be drawn from GlyphAtlas
+    std::vector<GlyphQuad> _overlayGlyphs;
+    Size _overlayGlyphsSize;
+    bool _overlayGlyphsValid = false; // _overlayAtlas and _overlayGlyphs are up to date
+    GlyphAtlas* _overlayAtlas = nullptr; // null if overlay can not be drawn from GlyphAtlas
+    Renderer _overlayAtlasRenderer = nullptr;
+    unsigned _overlayAtlasGeneration = 0;
     Label::HAlign _halign = Label::HAlign::LEFT;
     Label::VAlign _valign = Label::VAlign::TOP;
 
     virtual void addStage(int stage1, int stage2, SDL_Surface* surf, const std::string& name,
                           std::list<ImageFilter> filters={});
     void freeStage(int stage1, int stage2);
+    void reserveStage(int stage1, int stage2);
+    void finishStage(int stage1, int stage2, bool wait);
+    void loadStage(int stage1, int stage2);
+    void storeStage(int stage1, int stage2, SDL_Surface* surf);
+    void storeSize(int stage1, int stage2, int w, int h);
+    void drawOverlayGlyphs(Renderer renderer, GlyphAtlas* atlas, int x, int y);
 };
 
 } // namespace Ui
@@ -2,7 +2,7 @@
 #include "../core/pack.h"
 #include "../uilib/hbox.h"
 #include "../uilib/vbox.h"
-#include "../uilib/scrollvbox.h"
+#include "../uilib/scrolllist.h"
 #include "../uilib/label.h"
 #include "defaults.h" // DEFAULT_FONT_*
 
@@ -21,10 +21,36 @@ LoadPackWidget::LoadPackWidget(int x, int y, int w, int h, FontStore *fontStore)
         }
     }};
     
-    auto packs = new ScrollVBox(0,0,0,0);
+    // only visible rows have a label, they get reused when scrolling
+    auto packs = new ScrollList(0,0,0,0, [this]() -> Widget* {
+        auto lbl = new Label(0, 0, 0, 0, _font, ""); // TODO: button instead of label
+        lbl->setGrow(1,0);
+        lbl->setTextAlignment(Label::HAlign::LEFT, Label::VAlign::MIDDLE);
+        lbl->setMinSize({64,0});
+        lbl->onMouseEnter += {this,[this](void* s, int x, int y, unsigned buttons) {
+            size_t index = _packs->getRow((Widget*)s);
+            if (index >= _availablePacks.size() || index == _curPack) return;
+            _curPack = index;
+            _packs->refresh();
+            showVariants(index);
+        }};
+        return lbl;
+    }, [this](Widget* w, size_t index) {
+        auto lbl = (Label*)w;
+        if (index >= _availablePacks.size()) {
+            lbl->setText("No packs installed!");
+            lbl->setBackground({0,0,0,0});
+            return;
+        }
+        const auto& pack = _availablePacks[index];
+        lbl->setText(" " + pack.packName + " " + pack.version);
+        if (index == _curPack) lbl->setBackground({64,64,64});
+        else lbl->setBackground({32,32,32});
+    });
     packs->setGrow(1,1);
     packs->setPadding(0);
     packs->setSpacing(1);
+    packs->setRowHeight(32);
     _packs = packs;
     
     auto variants = new VBox(0,0,0,0);
@@ -45,71 +71,53 @@ LoadPackWidget::LoadPackWidget(int x, int y, int w, int h, FontStore *fontStore)
 
 void LoadPackWidget::update()
 {
-    auto availablePacks = Pack::ListAvailable();
-    _packs->clearChildren();
+    _availablePacks = Pack::ListAvailable();
+    _variants->clearChildren();
+    _curPack = ScrollList::NO_ROW;
+    _curVariantLabel = nullptr;
+    // one row for the "no packs" message
+    _packs->setRowCount(_availablePacks.empty() ? 1 : _availablePacks.size());
+    _packs->scrollTo(0, 0);
+    _main->setSize(_size);
+    _main->relayout(); // TODO: have this be done automatically
+}
+
+void LoadPackWidget::showVariants(size_t index)
+{
+    const auto& pack = _availablePacks[index];
     _variants->clearChildren();
-    _curPackLabel = nullptr;
     _curVariantLabel = nullptr;
-    for (auto& pack : availablePacks) {
-        auto lbl = new Label(0, 0, 0, 0, _font, " " + pack.packName + " " + pack.version); // TODO: button instead of label
+    for (auto& variant: pack.variants) {
+        auto lbl = new Label(0,0,0,0, _font, " " + variant.name); // TODO: button instead of label
         lbl->setGrow(1,0);
         lbl->setTextAlignment(Label::HAlign::LEFT, Label::VAlign::MIDDLE);
-        lbl->setMinSize({64,lbl->getAutoHeight()});
-        lbl->setSize({_size.width/2,32}); // TODO; hbox with even split instead
-        lbl->setBackground({32,32,32});
-        _packs->addChild(lbl);
-        lbl->onMouseEnter += {this,[this,pack](void* s, int x, int y, unsigned buttons) {
-            if (_curPackLabel == s) return;
-            if (_curPackLabel) _curPackLabel->setBackground({32,32,32});
-            _curPackLabel = (Label*)s;
-            _curPackLabel->setBackground({64,64,64});
-            _variants->clearChildren();
-            for (auto& variant: pack.variants) {
-                auto lbl = new Label(0,0,0,0, _font, " " + variant.name); // TODO: button instead of label
-                lbl->setGrow(1,0);
-                lbl->setTextAlignment(Label::HAlign::LEFT, Label::VAlign::MIDDLE);
-                lbl->setMinSize(lbl->getAutoSize());
-                lbl->setSize({_variants->getWidth(),32});
-                lbl->setBackground({64,64,64});
-                _variants->addChild(lbl);
-                lbl->onMouseLeave += {this,[this,variant](void *s) {
-                    if (_curVariantLabel != s) return;
-                    _curVariantLabel->setBackground({64,64,64});
-                    _curVariantLabel = nullptr;
-                }};
-                std::string path = pack.path;
-                lbl->onMouseEnter += {this,[this](void *s, int x, int y, unsigned buttons) {
-                    if (!s || s==_curVariantLabel) return;
-                    if (_curVariantLabel) _curVariantLabel->onMouseLeave.emit(_curVariantLabel);
-                    _curVariantLabel = (Label*)s;
-                    _curVariantLabel->setBackground({96,96,96});
-                }};
-                lbl->onClick += {this,[this,path,variant](void *s, int x, int y, int button) {
-                    if (button == MouseButton::BUTTON_LEFT) {
-                        onPackSelected.emit(this,path,variant.variant);
-                    }
-                }};
+        lbl->setMinSize(lbl->getAutoSize());
+        lbl->setSize({_variants->getWidth(),32});
+        lbl->setBackground({64,64,64});
+        _variants->addChild(lbl);
+        lbl->onMouseLeave += {this,[this,variant](void *s) {
+            if (_curVariantLabel != s) return;
+            _curVariantLabel->setBackground({64,64,64});
+            _curVariantLabel = nullptr;
+        }};
+        std::string path = pack.path;
+        lbl->onMouseEnter += {this,[this](void *s, int x, int y, unsigned buttons) {
+            if (!s || s==_curVariantLabel) return;
+            if (_curVariantLabel) _curVariantLabel->onMouseLeave.emit(_curVariantLabel);
+            _curVariantLabel = (Label*)s;
+            _curVariantLabel->setBackground({96,96,96});
+        }};
+        lbl->onClick += {this,[this,path,variant](void *s, int x, int y, int button) {
+            if (button == MouseButton::BUTTON_LEFT) {
+                onPackSelected.emit(this,path,variant.variant);
             }
-            auto spacer = new Label(0, 0, 0, 0, nullptr, "");
-            spacer->setGrow(1,1);
-            _variants->addChild(spacer);
-            _variants->relayout();
-            _main->relayout();
         }};
     }
-    if (availablePacks.empty()) {
-        auto lbl = new Label(0, 0, 0, 0, _font, "No packs installed!");
-        lbl->setGrow(1,1);
-        lbl->setTextAlignment(Label::HAlign::LEFT, Label::VAlign::MIDDLE);
-        lbl->setMinSize(lbl->getAutoSize());
-        lbl->setSize({_size.width/2,32}); // TODO; hbox with even split instead
-        _packs->addChild(lbl);
-        auto spacer = new Label(0, 0, 0, 0, nullptr, "");
-        spacer->setGrow(1,1);
-        _packs->addChild(spacer);
-    }
-    _main->setSize(_size);
-    _main->relayout(); // TODO: have this be done automatically
+    auto spacer = new Label(0, 0, 0, 0, nullptr, "");
+    spacer->setGrow(1,1);
+    _variants->addChild(spacer);
+    _variants->relayout();
+    _main->relayout();
 }
 
 void LoadPackWidget::setSize(Size size)
@@ -5,10 +5,11 @@
 #include "../uilib/simplecontainer.h"
 #include "../uilib/hbox.h"
 #include "../uilib/vbox.h"
-#include "../uilib/scrollvbox.h"
+#include "../uilib/scrolllist.h"
 #include "../uilib/label.h"
 #include "../uilib/fontstore.h"
 #include "../core/signal.h"
+#include "../core/pack.h"
 #include <SDL2/SDL_ttf.h>
 
 namespace Ui {
@@ -29,11 +30,14 @@ protected:
     FONT _font;
     FONT _smallFont;
     
-    ScrollVBox *_packs;
+    ScrollList *_packs;
     VBox *_variants;
     HBox *_main;
-    Label *_curPackLabel = nullptr;
+    std::vector<Pack::Info> _availablePacks;
+    size_t _curPack = ScrollList::NO_ROW;
     Label *_curVariantLabel = nullptr;
+
+    void showVariants(size_t index);
 };
 
 } // namespace Ui
@@ -1,5 +1,6 @@
 #include "mapwidget.h"
 #include "../core/util.h" // countOf
+#include <algorithm>
 
 namespace Ui {
 
@@ -118,26 +119,26 @@ void MapWidget::connectSignals()
         x1 = (x1*srcw + dstw/2) / dstw;
         y1 = (y1*srch + dsth/2) / dsth;
         bool match = false;
-        for (auto locIt = _locations.rbegin(); locIt!=_locations.rend(); locIt++) {
-            const auto& loc = locIt->second;
-            if (loc.state == -1) continue; // hidden
-            if (loc.state == 0 && _hideClearedLocations) continue;
-            if (loc.state == 2 && _hideUnreachableLocations) continue;
-            for (const auto& pos: loc.pos) {
-                int locsize = pos.size + 2 * pos.borderThickness; // or without border?
-                int locleft = pos.x - locsize/2;
-                int loctop = pos.y - locsize/2;
-                if (locleft < 0) locleft = 0;
-                if (loctop < 0) loctop = 0;
-                if (locleft > srcw-locsize) locleft=srcw-locsize;
-                if (loctop > srch-locsize) loctop=srch-locsize;
-                if (x1 >= locleft && x1 < locleft+locsize &&
-                    y1 >= loctop  && y1 < loctop+locsize)
+        if (!_hitGridValid || _hitGridSrcSize != Size{srcw, srch})
+            buildHitGrid(srcw, srch);
+        if (!_hitGrid.empty()) {
+            int cx = std::max(0, std::min(_hitGridW-1, x1 < 0 ? 0 : x1/HIT_CELL_SIZE));
+            int cy = std::max(0, std::min(_hitGridH-1, y1 < 0 ? 0 : y1/HIT_CELL_SIZE));
+            const auto& cell = _hitGrid[cy*_hitGridW + cx];
+            // entries are in draw order, last one that is visible and hit wins
+            for (auto entryIt = cell.rbegin(); entryIt != cell.rend(); entryIt++) {
+                const auto& entry = *entryIt;
+                const auto& loc = entry.loc->second;
+                if (loc.state == -1) continue; // hidden
+                if (loc.state == 0 && _hideClearedLocations) continue;
+                if (loc.state == 2 && _hideUnreachableLocations) continue;
+                if (x1 >= entry.left && x1 < entry.left+entry.size &&
+                    y1 >= entry.top  && y1 < entry.top+entry.size)
                 {
                     // TODO; store iterator instead of string?
                     match = true;
-                    if (locIt->first != _locationHover) {
-                        _locationHover = locIt->first;
+                    if (entry.loc->first != _locationHover) {
+                        _locationHover = entry.loc->first;
     #if 0
                         printf("MapWidget: hover location %s\n", _locationHover.c_str());
     #endif
@@ -156,17 +157,79 @@ void MapWidget::connectSignals()
     }};
 }
 
-void MapWidget::render(Renderer renderer, int offX, int offY)
+void MapWidget::buildHitGrid(int srcw, int srch)
 {
-    _absX = offX+_pos.left; // add this to relative mouse coordinates to get absolute
-    _absY = offY+_pos.top; // FIXME: we should provide absolute AND relative mouse position through the Event stack
-    Image::render(renderer, offX, offY);
-    
-    int srcw, srch, dstx, dsty, dstw, dsth;
-    calculateSizes(offX+_pos.left, offY+_pos.top, srcw, srch, dstx, dsty, dstw, dsth);
-    
+    // uniform grid over marker rects in map coordinates, each rect is added
+    // to all cells it touches in draw order
+    _hitGrid.clear();
+    _hitGridW = (srcw + HIT_CELL_SIZE - 1) / HIT_CELL_SIZE;
+    _hitGridH = (srch + HIT_CELL_SIZE - 1) / HIT_CELL_SIZE;
+    _hitGridSrcSize = {srcw, srch};
+    _hitGridValid = true;
+    if (_hitGridW < 1 || _hitGridH < 1) return;
+    _hitGrid.resize((size_t)_hitGridW * (size_t)_hitGridH);
+    auto cellX = [this](int x) { return std::max(0, std::min(_hitGridW-1, x < 0 ? 0 : x/HIT_CELL_SIZE)); };
+    auto cellY = [this](int y) { return std::max(0, std::min(_hitGridH-1, y < 0 ? 0 : y/HIT_CELL_SIZE)); };
+    for (auto locIt = _locations.cbegin(); locIt != _locations.cend(); locIt++) {
+        for (const auto& pos: locIt->second.pos) {
+            int locsize = pos.size + 2 * pos.borderThickness; // or without border?
+            int locleft = pos.x - locsize/2;
+            int loctop = pos.y - locsize/2;
+            if (locleft < 0) locleft = 0;
+            if (loctop < 0) loctop = 0;
+            if (locleft > srcw-locsize) locleft=srcw-locsize;
+            if (loctop > srch-locsize) loctop=srch-locsize;
+            if (locsize < 1) continue;
+            int x2 = cellX(locleft + locsize - 1);
+            int y2 = cellY(loctop + locsize - 1);
+            for (int cy = cellY(loctop); cy <= y2; cy++) {
+                for (int cx = cellX(locleft); cx <= x2; cx++) {
+                    _hitGrid[cy*_hitGridW + cx].push_back({locleft, loctop, locsize, locIt});
+                }
+            }
+        }
+    }
+}
+
+void MapWidget::addMarkerRect(const SDL_Rect& r, const Widget::Color& c)
+{
+    SDL_Color color = {c.r, c.g, c.b, c.a};
+    float x1 = (float)r.x, y1 = (float)r.y;
+    float x2 = (float)(r.x + r.w), y2 = (float)(r.y + r.h);
+    int n = (int)_markerVerts.size();
+    _markerVerts.push_back({{x1, y1}, color, {0, 0}});
+    _markerVerts.push_back({{x2, y1}, color, {0, 0}});
+    _markerVerts.push_back({{x2, y2}, color, {0, 0}});
+    _markerVerts.push_back({{x1, y2}, color, {0, 0}});
+    for (int i: {0, 1, 2, 0, 2, 3})
+        _markerIndices.push_back(n + i);
+}
+
+void MapWidget::addMarkerTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, const Widget::Color& color)
+{
+    SDL_Color sdlColor = {color.r, color.g, color.b, color.a};
+    int n = (int)_markerVerts.size();
+    _markerVerts.push_back({a, sdlColor, {0, 0}});
+    _markerVerts.push_back({b, sdlColor, {0, 0}});
+    _markerVerts.push_back({c, sdlColor, {0, 0}});
+    for (int i: {0, 1, 2})
+        _markerIndices.push_back(n + i);
+}
+
+void MapWidget::buildMarkers(int srcw, int srch, int dstx, int dsty, int dstw, int dsth)
+{
+    // tessellate all location markers in draw order, so they can be drawn with a single call
+    static const Widget::Color borderC = {0, 0, 0, 255};
+    _markerVerts.clear();
+    _markerIndices.clear();
+
     for (const auto& pair : _locations) {
         const auto& loc = pair.second;
+        int state = (int)loc.state;
+        if (state == -1) continue; // hidden
+        if (state == 0 && _hideClearedLocations) continue;
+        if (state == 2 && _hideUnreachableLocations) continue;
+
         for (const auto& pos : loc.pos) {
             // location icon size in screen space
             int locScreenInnerW  = (pos.size*dstw+srcw/2)/srcw;
@@ -198,45 +261,25 @@ void MapWidget::render(Renderer renderer, int offX, int offY)
             SDL_Rect outer = {
                 .x = outerx, .y = outery, .w = locScreenOuterW, .h = locScreenOuterH
             };
-            SDL_Rect outerTop = {
-                .x = outer.x, .y = outer.y, .w = outer.w, .h = borderScreenSize
-            };
-            SDL_Rect outerBot = {
-                .x = outer.x, .y = outer.y + outer.h - borderScreenSize, .w = outer.w, .h = borderScreenSize
-            };
-            SDL_Rect outerLeft = {
-                .x = outer.x, .y = outer.y, .w = borderScreenSize, .h = outer.h
-            };
-            SDL_Rect outerRight = {
-                .x = outer.x + outer.w - borderScreenSize, .y = outer.y, .w = borderScreenSize, .h = outer.h
-            };
-
-            int state = (int)loc.state;
-            if (state == -1) continue; // hidden
-            if (state == 0 && _hideClearedLocations) continue;
-            if (state == 2 && _hideUnreachableLocations) continue;
 
-            bool hasAlpha;
-
-            if (!SplitRects || state<0 || state>=countOf(triangleValues)) {
-                const Widget::Color& c = (state<0 || state>=countOf(StateColors)) ?
-                        StateColors[countOf(StateColors)-1] : StateColors[state];
-                hasAlpha = c.a < 0xff;
+            auto addBorder = [&](bool hasAlpha) {
                 if (hasAlpha) {
                     // we have to draw 4 individual lines for border
-                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                    SDL_RenderFillRect(renderer, &outerTop);
-                    SDL_RenderFillRect(renderer, &outerBot);
-                    SDL_RenderFillRect(renderer, &outerLeft);
-                    SDL_RenderFillRect(renderer, &outerRight);
+                    addMarkerRect({outer.x, outer.y, outer.w, borderScreenSize}, borderC);
+                    addMarkerRect({outer.x, outer.y + outer.h - borderScreenSize, outer.w, borderScreenSize}, borderC);
+                    addMarkerRect({outer.x, outer.y, borderScreenSize, outer.h}, borderC);
+                    addMarkerRect({outer.x + outer.w - borderScreenSize, outer.y, borderScreenSize, outer.h}, borderC);
                 } else {
-                    // border as bigger background rect (optimized for sw rendering)
-                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                    SDL_RenderFillRect(renderer, &outer);
+                    // border as bigger background rect
+                    addMarkerRect(outer, borderC);
                 }
-                SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
-                SDL_RenderFillRect(renderer, &inner);
+            };
 
+            if (!SplitRects || state<0 || state>=countOf(triangleValues)) {
+                const Widget::Color& c = (state<0 || state>=countOf(StateColors)) ?
+                        StateColors[countOf(StateColors)-1] : StateColors[state];
+                addBorder(c.a < 0xff);
+                addMarkerRect(inner, c);
                 continue;
             }
 
@@ -246,91 +289,73 @@ void MapWidget::render(Renderer renderer, int offX, int offY)
             const Widget::Color& botC = StateColors[values[2]];
             const Widget::Color& rightC = StateColors[values[3]];
 
-            hasAlpha = (topC.a < 0xff) ||
-                       (leftC.a < 0xff) ||
-                       (botC.a < 0xff) ||
-                       (rightC.a < 0xff);
+            bool hasAlpha = (topC.a < 0xff) ||
+                            (leftC.a < 0xff) ||
+                            (botC.a < 0xff) ||
+                            (rightC.a < 0xff);
 
             float fx = innerx;
             float fy = innery;
             float fw = locScreenInnerW;
             float fh = locScreenInnerH;
 
-            if (hasAlpha) {
-                // we have to draw 4 individual lines for border
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderFillRect(renderer, &outerTop);
-                SDL_RenderFillRect(renderer, &outerBot);
-                SDL_RenderFillRect(renderer, &outerLeft);
-                SDL_RenderFillRect(renderer, &outerRight);
-            } else {
-                // border as bigger background rect
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderFillRect(renderer, &outer);
-            }
+            addBorder(hasAlpha);
 
             if (!hasAlpha || (values[0] == values[1] && values[1] == values[2] && values[2] == values[3])) {
-                SDL_SetRenderDrawColor(renderer, botC.r, botC.g, botC.b, botC.a);
-                SDL_RenderFillRect(renderer, &inner);
+                addMarkerRect(inner, botC);
             } else if (values[2] == values[3]) {
-                SDL_Color botRightColor = {botC.r, botC.g, botC.b, botC.a};
-                SDL_Vertex botRightVerts[] = {
-                    {{fx + fw, fy}, botRightColor, {0, 0}},
-                    {{fx, fy + fh}, botRightColor, {0, 0}},
-                    {{fx + fw, fy + fh}, botRightColor, {0, 0}},
-                };
-                SDL_RenderGeometry(renderer, nullptr, botRightVerts, 3, nullptr, 0);
+                addMarkerTriangle({fx + fw, fy}, {fx, fy + fh}, {fx + fw, fy + fh}, botC);
             } else {
-                SDL_Color botColor = {botC.r, botC.g, botC.b, botC.a};
-                SDL_Vertex botVerts[] = {
-                    {{fx, fy + fh}, botColor, {0, 0}},
-                    {{fx + fw, fy + fw}, botColor, {0, 0}},
-                    {{fx + fw/2, fy + fh/2}, botColor, {0, 0}},
-                };
-                SDL_RenderGeometry(renderer, nullptr, botVerts, 3, nullptr, 0);
+                addMarkerTriangle({fx, fy + fh}, {fx + fw, fy + fw}, {fx + fw/2, fy + fh/2}, botC);
             }
 
-            if (values[2] != values[3]) {
-                SDL_Color rightColor = {rightC.r, rightC.g, rightC.b, rightC.a};
-                SDL_Vertex rightVerts[] = {
-                    {{fx + fw, fy}, rightColor, {0, 0}},
-                    {{fx + fw/2, fy + fh/2}, rightColor, {0, 0}},
-                    {{fx + fw, fy + fh}, rightColor, {0, 0}},
-                };
-                SDL_RenderGeometry(renderer, nullptr, rightVerts, 3, nullptr, 0);
-            }
+            if (values[2] != values[3])
+                addMarkerTriangle({fx + fw, fy}, {fx + fw/2, fy + fh/2}, {fx + fw, fy + fh}, rightC);
 
-            if (values[0] == values[1] && values[0] != values[2]) {
-                SDL_Color topLeftColor = {topC.r, topC.g, topC.b, topC.a};
-                SDL_Vertex topLeftVerts[] = {
-                    {{fx, fy}, topLeftColor, {0, 0}},
-                    {{fx, fy + fh}, topLeftColor, {0, 0}},
-                    {{fx + fw, fy}, topLeftColor, {0, 0}},
-                };
-                SDL_RenderGeometry(renderer, nullptr, topLeftVerts, 3, nullptr, 0);
-            }
+            if (values[0] == values[1] && values[0] != values[2])
+                addMarkerTriangle({fx, fy}, {fx, fy + fh}, {fx + fw, fy}, topC);
 
-            if (values[0] != values[1] && values[0] != values[2]) {
-                SDL_Color topColor = {topC.r, topC.g, topC.b, topC.a};
-                SDL_Vertex topVerts[] = {
-                    {{fx, fy}, topColor, {0, 0}},
-                    {{fx + fw/2, fy + fh/2}, topColor, {0, 0}},
-                    {{fx + fw, fy}, topColor, {0, 0}},
-                };
-                SDL_RenderGeometry(renderer, nullptr, topVerts, 3, nullptr, 0);
-            }
+            if (values[0] != values[1] && values[0] != values[2])
+                addMarkerTriangle({fx, fy}, {fx + fw/2, fy + fh/2}, {fx + fw, fy}, topC);
 
-            if (values[1] != values[0] && values[1] != values[2]) {
-                SDL_Color leftColor = {leftC.r, leftC.g, leftC.b, leftC.a};
-                SDL_Vertex leftVerts[] = {
-                    {{fx, fy}, leftColor, {0, 0}},
-                    {{fx, fy + fh}, leftColor, {0, 0}},
-                    {{fx + fw/2, fy + fh/2}, leftColor, {0, 0}},
-                };
-                SDL_RenderGeometry(renderer, nullptr, leftVerts, 3, nullptr, 0);
-            }
+            if (values[1] != values[0] && values[1] != values[2])
+                addMarkerTriangle({fx, fy}, {fx, fy + fh}, {fx + fw/2, fy + fh/2}, leftC);
         }
     }
+
+    _markerRect = {dstx, dsty, dstw, dsth};
+    _markerSrcSize = {srcw, srch};
+    _markerSplitRects = SplitRects;
+    _markersValid = true;
+}
+
+void MapWidget::render(Renderer renderer, int offX, int offY)
+{
+    _absX = offX+_pos.left; // add this to relative mouse coordinates to get absolute
+    _absY = offY+_pos.top; // FIXME: we should provide absolute AND relative mouse position through the Event stack
+    Image::render(renderer, offX, offY);
+    
+    int srcw, srch, dstx, dsty, dstw, dsth;
+    calculateSizes(offX+_pos.left, offY+_pos.top, srcw, srch, dstx, dsty, dstw, dsth);
+    if (srcw < 1 || srch < 1) return;
+
+    SDL_Rect rect = {dstx, dsty, dstw, dsth};
+    if (!_markersValid || _markerSplitRects != SplitRects || _markerSrcSize != Size{srcw, srch} ||
+            rect.w != _markerRect.w || rect.h != _markerRect.h) {
+        buildMarkers(srcw, srch, dstx, dsty, dstw, dsth);
+    } else if (rect.x != _markerRect.x || rect.y != _markerRect.y) {
+        // only moved, e.g. a neighbour was resized
+        float dx = (float)(rect.x - _markerRect.x);
+        float dy = (float)(rect.y - _markerRect.y);
+        for (auto& vert: _markerVerts) {
+            vert.position.x += dx;
+            vert.position.y += dy;
+        }
+        _markerRect = rect;
+    }
+    if (!_markerIndices.empty())
+        SDL_RenderGeometry(renderer, nullptr, _markerVerts.data(), (int)_markerVerts.size(),
+                _markerIndices.data(), (int)_markerIndices.size());
 }
 
 void MapWidget::addLocation(const std::string& id, int x, int y, int size, int borderThickness, int state)
@@ -341,14 +366,33 @@ void MapWidget::addLocation(const std::string& id, int x, int y, int size, int b
     } else {
         _locations[id] = { { {x, y, size, borderThickness} }, state};
     }
+    _markersValid = false;
+    _hitGridValid = false;
 }
 void MapWidget::setLocationState(const std::string& id, int state)
 {
     auto it = _locations.find(id);
-    if (it != _locations.end()) {
+    if (it != _locations.end() && it->second.state != state) {
         it->second.state = state;
+        _markersValid = false;
     }
 }
 
+void MapWidget::setHideClearedLocations(bool hide)
+{
+    if (_hideClearedLocations == hide) return;
+    _hideClearedLocations = hide;
+    _markersValid = false;
+    printf("hideCleared: %s\n", hide?"true":"false");
+}
+
+void MapWidget::setHideUnreachableLocations(bool hide)
+{
+    if (_hideUnreachableLocations == hide) return;
+    _hideUnreachableLocations = hide;
+    _markersValid = false;
+    printf("hideUnreachable: %s\n", hide?"true":"false");
+}
+
 
 } // namespace
@@ -4,6 +4,7 @@
 #include "../uilib/image.h"
 #include <map>
 #include <list>
+#include <vector>
 
 namespace Ui {
 
@@ -11,6 +12,7 @@ class MapWidget final : public Image {
 public:
     MapWidget(int x, int y, int w, int h, const char* filename);
     MapWidget(int x, int y, int w, int h, const void* data, size_t len);
+    virtual bool isRenderCacheable() const override { return false; }
     
     struct Point {
         int x=0;
@@ -35,8 +37,8 @@ public:
     int getAbsLeft() const { return _absX; } // FIXME: this is not really a good solution
     int getAbsTop() const { return _absY; }
 
-    void setHideClearedLocations(bool hide) { _hideClearedLocations = hide; printf("hideCleared: %s\n", hide?"true":"false"); }
-    void setHideUnreachableLocations(bool hide) { _hideUnreachableLocations = hide; printf("hideUnreachable: %s\n", hide?"true":"false"); }
+    void setHideClearedLocations(bool hide);
+    void setHideUnreachableLocations(bool hide);
 
     static const Widget::Color DEFAULT_STATE_COLORS[17];
     static Widget::Color StateColors[17];
@@ -51,9 +53,36 @@ protected:
     bool _hideClearedLocations = false;
     bool _hideUnreachableLocations = false;
 
+    // geometry of all location markers in screen space, rebuilt when locations
+    // change or the map gets resized, moved when the map moves
+    std::vector<SDL_Vertex> _markerVerts;
+    std::vector<int> _markerIndices;
+    bool _markersValid = false;
+    bool _markerSplitRects = false;
+    SDL_Rect _markerRect = {0,0,0,0};
+    Size _markerSrcSize;
+
+    // marker rects in map coordinates for hit tests
+    struct HitEntry {
+        int left;
+        int top;
+        int size;
+        std::map<std::string, Location>::const_iterator loc;
+    };
+    static constexpr int HIT_CELL_SIZE = 32;
+    std::vector<std::vector<HitEntry>> _hitGrid;
+    int _hitGridW = 0;
+    int _hitGridH = 0;
+    Size _hitGridSrcSize;
+    bool _hitGridValid = false;
+
 private:
     void connectSignals();
     void calculateSizes(int left, int top, int& srcw, int& srch, int& dstx, int& dsty, int& dstw, int& dsth);
+    void buildHitGrid(int srcw, int srch);
+    void buildMarkers(int srcw, int srch, int dstx, int dsty, int dstw, int dsth);
+    void addMarkerRect(const SDL_Rect& r, const Widget::Color& c);
+    void addMarkerTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, const Widget::Color& color);
 };
 
 } // namespace Ui
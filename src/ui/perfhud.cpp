@@ -0,0 +1,54 @@
+#include "perfhud.h"
+#include "../core/perfstats.h"
+#include "../uilib/texturestats.h"
+#include <algorithm>
+#include <stdio.h>
+
+
+namespace Ui {
+
+PerfHud::PerfHud(int x, int y, FONT font)
+    : Label(x, y, 0, 0, font, "")
+{
+    setTextAlignment(HAlign::LEFT, VAlign::TOP);
+    setBackground({0x00,0x00,0x00,0xbf});
+    update();
+}
+
+void PerfHud::update()
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "textures: %u, ~%u KiB, budget %u KiB\nhistogram: <=", (unsigned)TextureStats::getCount(),
+            (unsigned)(TextureStats::getBytes()/1024), (unsigned)(TextureStats::getBudget()/1024));
+    std::string legend = buf;
+    for (auto limit: PerfStats::HISTOGRAM_LIMITS)
+        legend += std::to_string(limit) + " ";
+    legend += "more (ms)";
+    setText(PerfStats::getSummary() + legend);
+    _histogram = PerfStats::getHistogram();
+    setSize({getAutoWidth(), getAutoHeight() + HISTOGRAM_HEIGHT});
+}
+
+void PerfHud::render(Renderer renderer, int offX, int offY)
+{
+    Label::render(renderer, offX, offY);
+    if (_histogram.empty()) return;
+    unsigned max = *std::max_element(_histogram.begin(), _histogram.end());
+    if (!max) return;
+    int barW = _size.width / (int)_histogram.size();
+    int bottom = offY + _pos.top + _size.height - 2;
+    int h = HISTOGRAM_HEIGHT - 4;
+    for (size_t i=0; i<_histogram.size(); i++) {
+        // green up to 60fps, yellow up to 30fps, red for slower frames
+        unsigned limit = i < _histogram.size()-1 ? PerfStats::HISTOGRAM_LIMITS[i] : (unsigned)-1;
+        if (limit <= 17) SDL_SetRenderDrawColor(renderer, 0x40, 0xff, 0x40, 0xff);
+        else if (limit <= 34) SDL_SetRenderDrawColor(renderer, 0xff, 0xff, 0x40, 0xff);
+        else SDL_SetRenderDrawColor(renderer, 0xff, 0x40, 0x40, 0xff);
+        int barH = (int)((uint64_t)_histogram[i] * (unsigned)h / max);
+        if (_histogram[i] && barH < 1) barH = 1;
+        SDL_Rect r = { offX + _pos.left + (int)i*barW + 1, bottom - barH, barW - 2, barH };
+        SDL_RenderFillRect(renderer, &r);
+    }
+}
+
+} // namespace Ui
@@ -0,0 +1,26 @@
+#ifndef _UI_PERFHUD_H
+#define _UI_PERFHUD_H
+
+#include "../uilib/label.h"
+#include <vector>
+
+namespace Ui {
+
+// Overlay that shows frame time statistics, see PerfStats
+class PerfHud : public Label {
+public:
+    PerfHud(int x, int y, FONT font);
+
+    // refresh from PerfStats
+    void update();
+    virtual void render(Renderer renderer, int offX, int offY) override;
+
+    static constexpr int HISTOGRAM_HEIGHT = 48;
+
+protected:
+    std::vector<unsigned> _histogram;
+};
+
+} // namespace Ui
+
+#endif // _UI_PERFHUD_H
@@ -9,6 +9,7 @@
 #include "../uilib/canvas.h"
 #include "../core/fileutil.h"
 #include "../core/assets.h"
+#include "../core/perfstats.h"
 #include "item.h"
 #include "mapwidget.h"
 #include "defaults.h" // DEFAULT_FONT_*
@@ -20,6 +21,34 @@ constexpr int TOOL_OFF=2;
 constexpr int TOOL_MAX_DISPLACEMENT=5; // can be off by this amount
 constexpr Size TOOL_MIN_SIZE={ 32,32 };
 
+static Widget::Color locationTooltipColor(unsigned state)
+{
+    if (state == 2) return {255,64,64}; // unreachable: red
+    if (state == 4 || state == 6) return {255,255,128}; // glitches required: yellow
+    if (state == 8 || state == 10) return {96,128,255}; // checkable: blue
+    return {255,255,255};
+}
+
+static Widget::Color sectionTooltipColor(AccessibilityLevel reachable, bool cleared)
+{
+    if (cleared) return {128,128,128}; // cleared: grey; TODO: use array for colors?
+    if (reachable == AccessibilityLevel::NONE) return {255,32,32}; // unreachable: red
+    if (reachable == AccessibilityLevel::SEQUENCE_BREAK) return {255,255,32}; // glitches required: yellow
+    if (reachable == AccessibilityLevel::INSPECT) return {48,64,255}; // checkable: blue
+    return {255,255,255};
+}
+
+static void setLocationIconOverlay(Item* w, const LocationSection& sec)
+{
+    int itemcount = sec.getItemCount();
+    int looted = sec.getItemCleared();
+    if (itemcount!=1 && itemcount>looted) { // TODO: show two numbers: looted + non-looted?
+        w->setOverlay(std::to_string(itemcount - looted));
+    } else {
+        w->setOverlay("");
+    }
+}
+
 std::list<ImageFilter> imageModsToFilters(Tracker* tracker, const std::list<std::string>& mods)
 {
     std::list<ImageFilter> filters;
@@ -32,15 +61,17 @@ std::list<ImageFilter> imageModsToFilters(Tracker* tracker, const std::list<std:
             arg  = mod.substr(p+1);
         }
         if (name == "overlay") {
-            // read actual image data into arg instead of filename
+            // read actual image data into arg instead of filename,
+            // the same overlay is usually used by many items
             std::string tmp = std::move(arg);
-            tracker->getPack()->ReadFile(tmp, arg);
+            tracker->getPack()->ReadFileCached(tmp, arg);
         }
         if (name == "@disable" || name == "@disabled")
         {
             name = "grey";
         }
         filters.push_back({name,arg});
+        filters.back().prepare(); // decode overlays here instead of on every decoder thread
     }
     return filters;
 }
@@ -65,8 +96,6 @@ static Label::VAlign str2itemValign(const std::string& s, Label::VAlign dflt=Lab
 
 Item* TrackerView::makeItem(int x, int y, int width, int height, const ::BaseItem& origItem, int stage1, int stage2)
 {
-    std::string f, s;
-
     // NOTE: for toggle_badged we use stage 1 (enable/disable) for the badge
     const ::BaseItem *item = &origItem;
     if (!origItem.getBaseItem().empty()) {
@@ -84,47 +113,46 @@ Item* TrackerView::makeItem(int x, int y, int width, int height, const ::BaseIte
     bool disabled = item->getAllowDisabled();
     bool stagedWithDisabled = item->getStageCount() && disabled;
 
-    for (size_t n=0; n==0||n<stages; n++) {
-        f = item->getImage(n);
+    // images are read now to get their size from the header,
+    // but filtered and decoded when the stage is shown first
+    auto addStage = [this, w](int stage1, int stage2, const std::string& f, const std::list<std::string>& mods) {
+        std::string s;
         _tracker->getPack()->ReadFile(f, s);
+        int width = 0, height = 0;
+        ImageDecoder::getSize(s, width, height);
+        w->addLazyStage(stage1, stage2, [this, w, stage1, stage2, f, mods, s]() {
+            w->addStage(stage1, stage2, s.c_str(), s.length(), f, imageModsToFilters(_tracker, mods));
+        }, {width, height});
+    };
+
+    for (size_t n=0; n==0||n<stages; n++) {
+        const auto& f = item->getImage(n);
         const auto& mods = item->getImageMods(n);
-        auto filters = imageModsToFilters(_tracker, mods);
         if (origItem.getType() == ::BaseItem::Type::TOGGLE_BADGED) {
             // stupid work-around: if base item is staged and has allow_disabled
             // we need to insert an additional stage for disabled state
             size_t m = stagedWithDisabled ? (n + 1) : n;
             if (item->getType() == ::BaseItem::Type::TOGGLE)
                 m = 1;
-            w->addStage(0, m, s.c_str(), s.length(), f, filters);
-            std::list<std::string> badgeMods = item->getImageMods(n);
+            addStage(0, m, f, mods);
+            std::list<std::string> badgeMods = mods;
             badgeMods.push_back("overlay|" + origItem.getImage(0));
-            auto badgeFilters = imageModsToFilters(_tracker, badgeMods);
-            w->addStage(1, m, s.c_str(), s.length(), f, badgeFilters);
+            addStage(1, m, f, badgeMods);
             if (n == 0 && m != 0) {
-                f = item->getDisabledImage(0);
-                _tracker->getPack()->ReadFile(f, s);
-                const auto& mods = item->getDisabledImageMods(0);
-                filters = imageModsToFilters(_tracker, mods);
-                w->addStage(0, 0, s.c_str(), s.length(), f, filters);
-                badgeMods = mods;
+                const auto& disF = item->getDisabledImage(0);
+                const auto& disMods = item->getDisabledImageMods(0);
+                addStage(0, 0, disF, disMods);
+                badgeMods = disMods;
                 badgeMods.push_back("overlay|" + origItem.getImage(0));
-                badgeFilters = imageModsToFilters(_tracker, badgeMods);
-                w->addStage(1, 0, s.c_str(), s.length(), f, badgeFilters);
+                addStage(1, 0, disF, badgeMods);
             }
         }
         else if (disabled) {
-            w->addStage(1, n, s.c_str(), s.length(), f, filters);
-            auto disF = item->getDisabledImage(n);
-            if (f != disF) {
-                f = disF;
-                _tracker->getPack()->ReadFile(f, s);
-            }
-            auto disMods = item->getDisabledImageMods(n);
-            filters = imageModsToFilters(_tracker, disMods);
-            w->addStage(0, n, s.c_str(), s.length(), f, filters);
+            addStage(1, n, f, mods);
+            addStage(0, n, item->getDisabledImage(n), item->getDisabledImageMods(n));
         }
         else {
-            w->addStage(1, n, s.c_str(), s.length(), f, filters);
+            addStage(1, n, f, mods);
         }
     }
     if (item->getCount()) {
@@ -165,6 +193,7 @@ Item* TrackerView::makeItem(int x, int y, int width, int height, const ::BaseIte
     }
     w->onDestroy += {this, [this,id] (void *s) {
         _items[id].remove((Item*)s);
+        _staleItems.erase((Item*)s);
     }};
     _items[id].push_back(w);
     
@@ -204,15 +233,8 @@ Item* TrackerView::makeLocationIcon(int x, int y, int width, int height, const s
     w->setMinSize(w->getSize()); // FIXME: this is a dirty work-around
     w->setOverlayBackgroundColor(sec.getOverlayBackground());
 
-    if (compact) {
-        int itemcount = sec.getItemCount();
-        int looted = sec.getItemCleared();
-        if (itemcount!=1 && itemcount>looted) { // TODO: show two numbers: looted + non-looted?
-            w->setOverlay(std::to_string(itemcount - looted));
-        } else {
-            w->setOverlay("");
-        }
-    }
+    if (compact)
+        setLocationIconOverlay(w, sec);
     
     auto name = sec.getName(); // TODO: id instead of name
     w->onClick += {this, [this,w,locid,name,compact](void*,int x, int y, int btn) {
@@ -242,7 +264,8 @@ Item* TrackerView::makeLocationIcon(int x, int y, int width, int height, const s
 
 
 TrackerView::TrackerView(int x, int y, int w, int h, Tracker* tracker, const std::string& layoutRoot, FontStore *fontStore)
-    : SimpleContainer(x,y,w,h), _tracker(tracker), _layoutRoot(layoutRoot), _fontStore(fontStore)
+    : SimpleContainer(x,y,w,h), _tracker(tracker), _locationStates(tracker->getLocationStates()),
+      _layoutRoot(layoutRoot), _fontStore(fontStore)
 {
     _font = _fontStore->getFont(DEFAULT_FONT_NAME, DEFAULT_FONT_SIZE);
     _smallFont = _fontStore->getFont(DEFAULT_FONT_NAME, DEFAULT_FONT_SIZE - 2);
@@ -260,8 +283,8 @@ TrackerView::TrackerView(int x, int y, int w, int h, Tracker* tracker, const std
     _tracker->onStateChanged += {this, [this](void *s, const std::string& check) {
         updateState(check);
     }};
-    _tracker->onLocationSectionChanged += {this, [this](void *s, const LocationSection& sec) {
-        updateLocations();
+    _locationStates->onChanged += {this, [this](void *s, const std::set<std::string>& changed) {
+        updateLocations(changed);
     }};
     updateLayout(layoutRoot);
     updateState("");
@@ -271,8 +294,9 @@ TrackerView::~TrackerView()
 {
     _tracker->onLayoutChanged -= this;
     _tracker->onStateChanged -= this;
-    _tracker->onLocationSectionChanged -= this;
+    _locationStates->onChanged -= this;
     _tracker->onUiHint -= this;
+    _tooltipPool.clear();
     _tracker = nullptr;
     
     for (auto pair: _items) {
@@ -282,17 +306,77 @@ TrackerView::~TrackerView()
     }
 }
 
+static void collectWidgets(Widget* w, std::set<Widget*>& widgets)
+{
+    widgets.insert(w);
+    auto container = dynamic_cast<Container*>(w);
+    if (!container) return;
+    for (auto child: container->getChildren())
+        collectWidgets(child, widgets);
+}
+
 void TrackerView::relayout()
 {
     const LayoutNode node = _tracker->getLayout(_layoutRoot);
     _relayoutRequired = false;
     _tracker->onUiHint -= this; // stop recording hints
+
+    // detach old ui, unchanged parts of it get moved into the new one
+    _mapTooltip = nullptr; // deleted with the old ui
+    _mapTooltipOwner = nullptr;
+    _tooltipPool.clear(); // pooled widgets may refer to the old layout
+    auto oldUi = _children;
+    for (auto w: oldUi)
+        removeChild(w);
+    if (!_fullRebuild) {
+        _reusableNodes = std::move(_builtNodes);
+        _reusableNodesByKey = std::move(_builtNodesByKey);
+    }
+    _builtNodes.clear();
+    _builtNodesByKey.clear();
+    _layoutRefs.clear();
+
     if (node.getType() != "") addLayoutNode(this, node);
+    flushLayout();
+
+    // delete what was not reused
+    std::set<Widget*> dead;
+    oldUi.erase(std::remove_if(oldUi.begin(), oldUi.end(), [this](Widget* w) {
+        return _takenNodes.count(w) > 0;
+    }), oldUi.end());
+    for (auto w: oldUi)
+        collectWidgets(w, dead);
+    _tabs.remove_if([&dead](Tabs* w) { return dead.count(w) > 0; });
+    for (auto it = _maps.begin(); it != _maps.end();) {
+        it->second.remove_if([&dead](MapWidget* w) { return dead.count(w) > 0; });
+        if (it->second.empty())
+            it = _maps.erase(it);
+        else
+            ++it;
+    }
+    for (auto w: oldUi)
+        delete w; // items remove themselves from _items
+    _reusableNodes.clear();
+    _reusableNodesByKey.clear();
+    _takenNodes.clear();
+    _changedLayouts.clear();
+    _fullRebuild = false;
+
+    _tracker->onUiHint += { this, [this](void* s, const std::string& name, const std::string& value) {
+        for (auto w: _tabs) {
+            if (name == "ActivateTab") {
+                w->setActiveTab(value);
+            } else if (name =="reset") {
+                w->setActiveTab(0);
+            }
+        }
+    }};
     for (const auto& pair : _missedHints) { // replay missed layout hints
         _tracker->onUiHint.emit(_tracker, pair.first, pair.second);
     }
     _missedHints.clear();
     updateLocations();
+    updateStale(); // reused widgets may have become visible
 }
 
 void TrackerView::render(Renderer renderer, int offX, int offY)
@@ -302,6 +386,7 @@ void TrackerView::render(Renderer renderer, int offX, int offY)
         setSize({300,200}); // FIXME: we should really fix relayout() at some point
         relayout();
         setSize(oldSize);
+        flushLayout(); // this is after the window resolved layouts for this frame
     }
     // store global coordinates for overlay calculations
     _absX = offX+_pos.left;
@@ -365,15 +450,12 @@ void TrackerView::updateLayout(const std::string& layout)
         if (!name.empty()) _activeTabs.push_back(name);
     }
     
-    // clear ui
+    // the ui gets updated in relayout(), reusing widgets of unchanged layout nodes
+    if (layout.empty())
+        _fullRebuild = true; // items, maps or locations changed
+    else
+        _changedLayouts.insert(layout);
     _tracker->onUiHint -= this;
-    _mapTooltip = nullptr;
-    _mapTooltipOwner = nullptr;
-    _items.clear();
-    _maps.clear();
-    _tabs.clear();
-    _layoutRefs.clear();
-    clearChildren();
     _relayoutRequired = true;
     
     // record "missed" hints during update to replay them later
@@ -384,24 +466,47 @@ void TrackerView::updateLayout(const std::string& layout)
 
 void TrackerView::updateLocations()
 {
+    // sync all map locations, states are only calculated if no other view did yet
+    PerfStats::Timer timer(PerfStats::Section::LOCATIONS);
+    _staleMaps.clear();
     for (auto& mappair: _maps) {
-        //const auto& map = _tracker->getMap(mappair.first);
-        for (auto& w: mappair.second) {
-            for (const auto& pair : _tracker->getMapLocations(mappair.first)) {
-                int state = calculateLocationState(pair.first);
-                if (_maps.size()<1) {
-                    printf("TrackerView: UI changed during updateLocations()\n");
-                    fprintf(stderr, "cybuuuuuu!!\n");
-                    return;
-                }
+        const auto locations = _tracker->getMapLocations(mappair.first);
+        for (const auto& pair : locations) {
+            int state = _locationStates->getState(pair.first);
+            if (_maps.size()<1) {
+                printf("TrackerView: UI changed during updateLocations()\n");
+                fprintf(stderr, "cybuuuuuu!!\n");
+                return;
+            }
+            for (auto& w: mappair.second)
                 w->setLocationState(pair.first, state);
+        }
+    }
+    updateMapTooltipState();
+}
+
+void TrackerView::updateLocations(const std::set<std::string>& changed)
+{
+    // states were already calculated by _locationStates, only apply the diff
+    for (const auto& locid: changed) {
+        int state = _locationStates->getState(locid);
+        for (auto& mappair: _maps) {
+            for (auto& w: mappair.second) {
+                if (w->isShown())
+                    w->setLocationState(locid, state);
+                else
+                    _staleMaps.insert(w);
             }
         }
     }
-    // dirty work-around: just run the hove signal to recreate tooltip
-    // FIXME: we probably want to have a custom widget for that
+    // section colors may change without changing the location state
+    updateMapTooltipState();
+}
 
-    if (_mapTooltip && _mapTooltipOwner) {
+void TrackerView::updateMapTooltipState()
+{
+    // update tooltip in place if possible, otherwise run the hover signal to recreate it
+    if (_mapTooltip && _mapTooltipOwner && !updateMapTooltip()) {
         _mapTooltipOwner->onLocationHover.emit(_mapTooltipOwner, _mapTooltipName, _mapTooltipPos.left, _mapTooltipPos.top);
     }
 }
@@ -410,58 +515,88 @@ void TrackerView::updateState(const std::string& itemid)
     const auto& item = _tracker->getItemById(itemid);
     printf("update state of %s: \"%s\"\n", itemid.c_str(), item.getName().c_str());
     for (auto w: _items[itemid]) {
-        if (item.getType() == ::BaseItem::Type::CUSTOM) {
-            int st = item.getActiveStage();
-            auto filters = imageModsToFilters(_tracker, item.getImageMods(st));
-            auto f = item.getImage(st);
-            // TODO: cache image instead always reloading it
-            if (!w->isStage(w->getStage1(), w->getStage2(), f, filters)) {
-                std::string s;
-                _tracker->getPack()->ReadFile(f, s);
-                w->addStage(w->getStage1(), w->getStage2(), s.c_str(), s.length(), f, filters);
-                printf("Image updated!\n");
-            }
-        } else if (item.getType() == ::BaseItem::Type::TOGGLE_BADGED) {
-            // stage is controlled by base item, state by badge
-            // stupid hack: if the base item is staged and it has
-            // allow_disabled, we need to add a "disabled" stage
-            int stage = item.getActiveStage();
-            auto o = _tracker->FindObjectForCode(item.getBaseItem().c_str());
-            if (o.type == Tracker::Object::RT::JsonItem) {
-                stage = o.jsonItem->getActiveStage();
-                if (o.jsonItem->getStageCount() && o.jsonItem->getAllowDisabled())
-                    stage = o.jsonItem->getState() ? stage+1 : 0;
-                else if (o.jsonItem->getType() == BaseItem::Type::TOGGLE)
-                    stage = o.jsonItem->getState();
-            } else if (o.type == Tracker::Object::RT::LuaItem) {
-                stage = o.luaItem->getActiveStage();
-                if (o.luaItem->getStageCount()>1 && o.luaItem->getAllowDisabled())
-                    stage = o.luaItem->getState() ? stage+1 : 0;
-            }
-            w->setStage(item.getState(), stage);
+        if (w->isShown())
+            updateItem(w, item);
+        else
+            _staleItems[w] = itemid; // update when its tab gets activated
+    }
+    // locations are updated through _locationStates
+}
+
+void TrackerView::updateItem(Item* w, const ::BaseItem& item)
+{
+    if (item.getType() == ::BaseItem::Type::CUSTOM) {
+        int st = item.getActiveStage();
+        auto filters = imageModsToFilters(_tracker, item.getImageMods(st));
+        auto f = item.getImage(st);
+        // TODO: cache image instead always reloading it
+        if (!w->isStage(w->getStage1(), w->getStage2(), f, filters)) {
+            std::string s;
+            _tracker->getPack()->ReadFile(f, s);
+            w->addStage(w->getStage1(), w->getStage2(), s.c_str(), s.length(), f, filters);
+            printf("Image updated!\n");
+        }
+    } else if (item.getType() == ::BaseItem::Type::TOGGLE_BADGED) {
+        // stage is controlled by base item, state by badge
+        // stupid hack: if the base item is staged and it has
+        // allow_disabled, we need to add a "disabled" stage
+        int stage = item.getActiveStage();
+        auto o = _tracker->FindObjectForCode(item.getBaseItem().c_str());
+        if (o.type == Tracker::Object::RT::JsonItem) {
+            stage = o.jsonItem->getActiveStage();
+            if (o.jsonItem->getStageCount() && o.jsonItem->getAllowDisabled())
+                stage = o.jsonItem->getState() ? stage+1 : 0;
+            else if (o.jsonItem->getType() == BaseItem::Type::TOGGLE)
+                stage = o.jsonItem->getState();
+        } else if (o.type == Tracker::Object::RT::LuaItem) {
+            stage = o.luaItem->getActiveStage();
+            if (o.luaItem->getStageCount()>1 && o.luaItem->getAllowDisabled())
+                stage = o.luaItem->getState() ? stage+1 : 0;
+        }
+        w->setStage(item.getState(), stage);
+    } else {
+        w->setStage(item.getState(), item.getActiveStage());
+    }
+    if (item.getCount()) {
+        if (item.getCount() == item.getMaxCount()) {
+            w->setOverlayColor({31,255,31});
         } else {
-            w->setStage(item.getState(), item.getActiveStage());
+            w->setOverlayColor({220,220,220});
         }
-        if (item.getCount()) {
-            if (item.getCount() == item.getMaxCount()) {
-                w->setOverlayColor({31,255,31});
-            } else {
-                w->setOverlayColor({220,220,220});
-            }
-            w->setOverlay(std::to_string(item.getCount()));
+        w->setOverlay(std::to_string(item.getCount()));
+        w->setFont(_fontStore->getFont(DEFAULT_FONT_NAME,
+                FontStore::sizeFromData(DEFAULT_FONT_SIZE, item.getOverlayFontSize())));
+    } else {
+        auto s = item.getOverlay();
+        w->setOverlay(s);
+        if (!s.empty()) {
+            w->setOverlayColor({220,220,220});
             w->setFont(_fontStore->getFont(DEFAULT_FONT_NAME,
                     FontStore::sizeFromData(DEFAULT_FONT_SIZE, item.getOverlayFontSize())));
+        }
+    }
+}
+
+void TrackerView::updateStale()
+{
+    for (auto it = _staleItems.begin(); it != _staleItems.end();) {
+        if (it->first->isShown()) {
+            auto w = it->first;
+            auto id = it->second;
+            it = _staleItems.erase(it);
+            updateItem(w, _tracker->getItemById(id));
         } else {
-            auto s = item.getOverlay();
-            w->setOverlay(s);
-            if (!s.empty()) {
-                w->setOverlayColor({220,220,220});
-                w->setFont(_fontStore->getFont(DEFAULT_FONT_NAME,
-                        FontStore::sizeFromData(DEFAULT_FONT_SIZE, item.getOverlayFontSize())));
-            }
+            ++it;
+        }
+    }
+    for (auto& mappair: _maps) {
+        for (auto& w: mappair.second) {
+            if (!_staleMaps.count(w) || !w->isShown()) continue;
+            _staleMaps.erase(w);
+            for (const auto& pair : _tracker->getMapLocations(mappair.first))
+                w->setLocationState(pair.first, _locationStates->getState(pair.first));
         }
     }
-    updateLocations();
 }
 
 size_t TrackerView::addLayoutNodes(Container* container, const std::list<LayoutNode>& nodes, size_t depth)
@@ -474,10 +609,103 @@ size_t TrackerView::addLayoutNodes(Container* container, const std::list<LayoutN
     }
     return n;
 }
+size_t TrackerView::layoutNodeKey(const Container* container, const LayoutNode& node) const
+{
+    // widgets also depend on some properties of the parent
+    bool box = dynamic_cast<const HBox*>(container) || dynamic_cast<const VBox*>(container);
+    return node.getHash() * 4 + (container->getDropShadow() ? 2 : 0) + (box ? 1 : 0);
+}
+
+Widget* TrackerView::takeBuiltNode(size_t key, std::set<std::string>& refs)
+{
+    auto range = _reusableNodesByKey.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        Widget* w = it->second;
+        if (_takenNodes.count(w)) continue;
+        auto nodeIt = _reusableNodes.find(w);
+        if (nodeIt == _reusableNodes.end()) continue;
+        const BuiltNode& old = nodeIt->second;
+        if (old.broken) continue;
+        bool changed = false;
+        for (const auto& ref: old.refs) {
+            if (_changedLayouts.count(ref)) {
+                changed = true;
+                break;
+            }
+        }
+        if (changed) continue;
+        refs = old.refs;
+        old.parent->removeChild(w);
+        // parents can not be reused as a whole anymore
+        for (auto p = _reusableNodes.find(old.parent); p != _reusableNodes.end();
+                p = _reusableNodes.find(p->second.parent))
+            p->second.broken = true;
+        // keep track of nodes in the subtree for the next relayout
+        std::set<Widget*> subtree;
+        collectWidgets(w, subtree);
+        for (auto child: subtree) {
+            _takenNodes.insert(child);
+            auto childIt = _reusableNodes.find(child);
+            if (childIt == _reusableNodes.end()) continue;
+            for (auto childKey: childIt->second.keys)
+                _builtNodesByKey.insert({childKey, child});
+            _builtNodes[child] = childIt->second;
+        }
+        return w;
+    }
+    return nullptr;
+}
+
 bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, size_t depth)
 {
     // This returns true if a child was added, false otherwise
-    
+
+    size_t key = layoutNodeKey(container, node);
+    std::set<std::string> refs;
+    Widget* w = takeBuiltNode(key, refs);
+    if (w) {
+#ifdef DEBUG_LAYOUT_TREE
+        printf("%sreusing layout node '%s'\n", std::string(depth*2,' ').c_str(),
+                                             node.getType().c_str());
+#endif
+        const LayoutNode& origin = (node.getType() == "layout") ? _tracker->getLayout(node.getKey()) : node;
+        if (origin.getType() == "item")
+            w->setPosition({origin.getPosition().x, origin.getPosition().y});
+        else
+            w->setPosition({0,0});
+        w->setVisible(true); // may have been an inactive tab
+        _builtNodes[w].parent = container;
+        container->addChild(w);
+    } else {
+        auto parentRefs = _buildRefs;
+        _buildRefs = &refs;
+        bool res = buildLayoutNode(container, node, depth);
+        _buildRefs = parentRefs;
+        if (res) {
+            w = container->getChildren().back();
+            auto& built = _builtNodes[w];
+            built.parent = container;
+            built.refs.insert(refs.begin(), refs.end());
+            if (std::find(built.keys.begin(), built.keys.end(), key) == built.keys.end()) {
+                // "layout" nodes share the widget with the node they reference
+                built.keys.push_back(key);
+                _builtNodesByKey.insert({key, w});
+            }
+        }
+    }
+    // record references even if nothing was built, so a referenced layout
+    // that gets added later by AddLayouts() still triggers a relayout
+    for (const auto& ref: refs) {
+        if (std::find(_layoutRefs.begin(), _layoutRefs.end(), ref) == _layoutRefs.end())
+            _layoutRefs.push_back(ref);
+    }
+    if (_buildRefs)
+        _buildRefs->insert(refs.begin(), refs.end());
+    return w != nullptr;
+}
+
+bool TrackerView::buildLayoutNode(Container* container, const LayoutNode& node, size_t depth)
+{
     if (depth>63) {
         fprintf(stderr, "Layout depth too high!\n");
         return false;
@@ -578,15 +806,11 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
                 }
             }
         }
-        container->addChild(w);
-        _tabs.push_back(w);
-        _tracker->onUiHint += { this, [this,w](void* s, const std::string& name, const std::string& value) {
-            if (name == "ActivateTab") {
-                w->setActiveTab(value);
-            } else if (name =="reset") {
-                w->setActiveTab(0);
-            }
+        w->onActiveTabChanged += {this, [this](void*) {
+            updateStale();
         }};
+        container->addChild(w);
+        _tabs.push_back(w); // hints are handled in relayout()
     }
     else if (node.getType() == "group") {
         Container *w = new Group(0,0,0,0,_font,node.getHeader());
@@ -597,6 +821,8 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
             w->setBackground({"#7f000000"});
         else
             w->setBackground({"#4a000000"});
+        // groups of labels, images and items only change when one of them does
+        w->setRenderCache(true);
         addLayoutNodes(w, children, depth+1);
         container->addChild(w);
     }
@@ -618,6 +844,7 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
         if (maxSz.y > 0) w->setMaxSize( {w->getMaxHeight(), maxSz.y} );
         if (!node.getBackground().empty()) w->setBackground(node.getBackground());
         // FIXME: this is a dirty work-around. make auto-layout better
+        w->waitForSize(); // auto size depends on the images of all stages, read from the headers if possible
         w->setMinSize(w->getAutoSize());
         if (w->getMaxWidth()>0 && w->getMaxWidth() < w->getMinWidth()) {
             int calculatedHeight = w->getMaxWidth()*w->getAutoHeight()/w->getAutoWidth(); // keep aspect ratio
@@ -739,7 +966,7 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
                         // run destructor after removing reference since delete may also fire
                         auto tmp = _mapTooltip;
                         _mapTooltip = nullptr;
-                        delete tmp;
+                        _tooltipPool.recycle(tmp);
                     }
                 }
 
@@ -778,7 +1005,8 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
                             _mapTooltip->setTop(mapTop);
                     }
                 }
-                // restore scroll position
+                // restore scroll position, scroll range depends on the final size
+                _mapTooltip->flushLayout();
                 _mapTooltip->scrollTo(0, _mapTooltipScrollOffsets[locid]);
                 // add tooltip to widgets
                 addChild(_mapTooltip);
@@ -796,7 +1024,7 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
                             // run destructor after removing reference since delete may also fire
                             auto tmp = _mapTooltip;
                             _mapTooltip = nullptr;
-                            delete tmp;
+                            _tooltipPool.recycle(tmp);
                         }
                     }
                 }};
@@ -871,7 +1099,7 @@ bool TrackerView::addLayoutNode(Container* container, const LayoutNode& node, si
         container->addChild(w);
     }
     else if (node.getType() == "layout") {
-        _layoutRefs.push_back(node.getKey());
+        if (_buildRefs) _buildRefs->insert(node.getKey());
         return addLayoutNode(container, _tracker->getLayout(node.getKey()), depth+1);
     }
     else if (node.getType() == "text") {
@@ -924,20 +1152,28 @@ ScrollVBox* TrackerView::makeMapTooltip(const std::string& locid, int x, int y)
     tooltip->setPadding(2*TOOL_OFF);
     tooltip->setSpacing(TOOL_OFF);
 
+    _mapTooltipTitle = nullptr;
+    _mapTooltipSections.clear();
+
     auto& loc = _tracker->getLocation(locid);
     const auto& name = loc.getName();
     if (!name.empty()) {
-        Label* lbl = new Label(0,0,0,0, _font, name);
-        unsigned state = calculateLocationState(locid);
-        if (state == 2) lbl->setTextColor({255,64,64}); // unreachable: red
-        else if (state == 4 || state == 6) lbl->setTextColor({255,255,128}); // glitches required: yellow
-        else if (state == 8 || state == 10) lbl->setTextColor({96,128,255}); // checkable: blue
-        lbl->setTextAlignment(Label::HAlign::RIGHT, Label::VAlign::MIDDLE);
-        lbl->setSize(lbl->getSize()||lbl->getMinSize()); // FIXME: this should not be neccessary
-        lbl->setMinSize(lbl->getSize()||lbl->getMinSize());
+        // labels and icons are reused from previous tooltips by content
+        Label* lbl = _tooltipPool.take<Label>("title:" + name);
+        if (!lbl) {
+            lbl = _tooltipPool.add("title:" + name, new Label(0,0,0,0, _font, name));
+            lbl->setTextAlignment(Label::HAlign::RIGHT, Label::VAlign::MIDDLE);
+            lbl->setSize(lbl->getSize()||lbl->getMinSize()); // FIXME: this should not be neccessary
+            lbl->setMinSize(lbl->getSize()||lbl->getMinSize());
+        } else {
+            lbl->setSize(lbl->getMinSize()); // was stretched by the previous tooltip
+        }
+        lbl->setTextColor(locationTooltipColor(_locationStates->getState(locid)));
+        _mapTooltipTitle = lbl;
         tooltip->addChild(lbl);
     }
     
+    std::list<Item*> icons; // all icons of the tooltip, to wait for decoding once
     Container* sectionContainer;
     bool horizontalSections = false; //= compact;
     if (horizontalSections) {
@@ -966,15 +1202,19 @@ ScrollVBox* TrackerView::makeMapTooltip(const std::string& locid, int x, int y)
             Container* c = horizontalSections ? (Container*)new VBox(0,0,0,0) : (Container*)tooltip;
 
             const std::string& name = ogSec.getName().empty() ? sec.getName() : ogSec.getName();
+            _mapTooltipSections.push_back({name, hostedItems});
             if (!name.empty()) {
-                Label* lbl = new Label(0,0,0,0, _smallFont, name);
-                if (cleared) lbl->setTextColor({128,128,128}); // cleared: grey; TODO: use array for colors?
-                else if (reachable == AccessibilityLevel::NONE) lbl->setTextColor({255,32,32}); // unreachable: red
-                else if (reachable == AccessibilityLevel::SEQUENCE_BREAK) lbl->setTextColor({255,255,32}); // glitches required: yellow
-                else if (reachable == AccessibilityLevel::INSPECT) lbl->setTextColor({48,64,255}); // checkable: blue
-                lbl->setTextAlignment(Label::HAlign::LEFT, Label::VAlign::MIDDLE);
-                lbl->setSize(lbl->getSize()||lbl->getMinSize()); // FIXME: this should not be neccessary
-                lbl->setMinSize(lbl->getSize()||lbl->getMinSize());
+                Label* lbl = _tooltipPool.take<Label>("section:" + name);
+                if (!lbl) {
+                    lbl = _tooltipPool.add("section:" + name, new Label(0,0,0,0, _smallFont, name));
+                    lbl->setTextAlignment(Label::HAlign::LEFT, Label::VAlign::MIDDLE);
+                    lbl->setSize(lbl->getSize()||lbl->getMinSize()); // FIXME: this should not be neccessary
+                    lbl->setMinSize(lbl->getSize()||lbl->getMinSize());
+                } else {
+                    lbl->setSize(lbl->getMinSize());
+                }
+                lbl->setTextColor(sectionTooltipColor(reachable, cleared));
+                _mapTooltipSections.back().label = lbl;
                 c->addChild(lbl);
             }
 
@@ -983,14 +1223,36 @@ ScrollVBox* TrackerView::makeMapTooltip(const std::string& locid, int x, int y)
             int looted = sec.getItemCleared();
             for (int i=0; i<itemcount; i++) {
                 bool opened = compact ? looted>=itemcount : i<=looted;
-                Item *w = makeLocationIcon(0,0,32,32, sec.getParentID(), sec, opened, compact);
+                std::string key = "icon:" + sec.getParentID() + "/" + sec.getName() + (compact ? "" : "/" + std::to_string(i));
+                Item *w = _tooltipPool.take<Item>(key);
+                if (w) {
+                    w->setSize(w->getMinSize());
+                    w->setStage(opened?1:0,0);
+                    if (compact)
+                        setLocationIconOverlay(w, sec);
+                } else {
+                    w = _tooltipPool.add(key, makeLocationIcon(0,0,32,32, sec.getParentID(), sec, opened, compact));
+                }
                 hbox->addChild(w);
-                if (compact) break;
+                icons.push_back(w);
+                if (compact) {
+                    _mapTooltipSections.back().icon = w;
+                    break;
+                }
             }
             for (const auto& item: hostedItems) {
-                Item *w = makeItem(0,0,32,32, _tracker->getItemByCode(item));
-                w->setMinSize(w->getSize()); // FIXME: this is a dirty work-around
+                Item *w = _tooltipPool.take<Item>("item:" + item);
+                if (w) {
+                    w->setSize(w->getMinSize());
+                    // pooled items are hidden and miss updates
+                    _staleItems.erase(w);
+                    updateItem(w, _tracker->getItemByCode(item));
+                } else {
+                    w = _tooltipPool.add("item:" + item, makeItem(0,0,32,32, _tracker->getItemByCode(item)));
+                    w->setMinSize(w->getSize()); // FIXME: this is a dirty work-around
+                }
                 hbox->addChild(w);
+                icons.push_back(w);
             }
             hbox->relayout(); // FIXME: this should not be neccessary
             c->addChild(hbox); 
@@ -1000,7 +1262,11 @@ ScrollVBox* TrackerView::makeMapTooltip(const std::string& locid, int x, int y)
     }
     if (sectionContainer != tooltip)
         tooltip->addChild(sectionContainer);
+    // tooltips get rebuilt a lot, don't flash empty icons. icons have a fixed size,
+    // so all of them decode in parallel while the layout is built
+    for (auto w: icons) w->waitForStages();
     //tooltip->relayout(); // FIXME: this should not be neccessary
+    tooltip->flushLayout();
     
     tooltip->setMinSize(tooltip->getMinSize() || TOOL_MIN_SIZE);
     tooltip->setBackground({0x00,0x00,0x00,0xbf});
@@ -1010,67 +1276,48 @@ ScrollVBox* TrackerView::makeMapTooltip(const std::string& locid, int x, int y)
     return tooltip;
 }
 
-
-int TrackerView::calculateLocationState(const std::string& locid)
+bool TrackerView::updateMapTooltip()
 {
-    auto& loc = _tracker->getLocation(locid);
-    bool hasReachable = false;
-    bool hasUnreachable = false;
-    bool hasGlitchedReachable = false;
-    bool hasCheckable = false;
-    bool hasVisible = false;
-
-    for (const auto& ogSec: loc.getSections()) {
+    // Updates colors and icons of the current tooltip from location state.
+    // Returns false if sections or hosted items changed and the tooltip has to be rebuilt.
+    auto& loc = _tracker->getLocation(_mapTooltipName);
+    std::list<std::pair<MapTooltipSection*, const LocationSection*>> matched;
+    auto it = _mapTooltipSections.begin();
+    for (const auto& ogSec : loc.getSections()) {
         const auto& sec = ogSec.getRef().empty() ? ogSec : _tracker->getLocationSection(ogSec.getRef());
-
-        if (!_tracker->isVisible(loc, sec))
-            continue;
+        if (!_tracker->isVisible(loc, sec)) continue;
 
         std::list<std::string> hostedItems;
-        if (sec.getItemCleared() >= sec.getItemCount()) {
-            // be lazy about filling hostedItems
-            for (const auto& code : sec.getHostedItems()) {
-                if (_tracker->getItemByCode(code).getType() != BaseItem::Type::NONE)
-                    hostedItems.push_back(code);
-            }
-            // ignore section if empty
-            if (sec.getItemCount() < 1 && hostedItems.size() < 1)
-                continue;
+        for (const auto& hostedItem: sec.getHostedItems()) {
+            if (_tracker->getItemByCode(hostedItem).getType() != BaseItem::Type::NONE)
+                hostedItems.push_back(hostedItem);
         }
+        if (sec.getItemCount() <= 0 && hostedItems.empty()) continue;
 
-        hasVisible = true;
-
-        if (sec.getItemCleared() >= sec.getItemCount()) {
-            // check hosted items
-            bool missing = false;
-            for (const auto& code: hostedItems) {
-                if (!_tracker->ProviderCountForCode(code)) {
-                    missing = true;
-                    break;
-                }
-            }
-            if (!missing) continue;
-        }
+        const std::string& name = ogSec.getName().empty() ? sec.getName() : ogSec.getName();
+        if (it == _mapTooltipSections.end() || it->name != name || it->hostedItems != hostedItems
+                || (it->icon != nullptr) != (sec.getItemCount() > 0))
+            return false;
+        matched.push_back({&*it, &sec});
+        ++it;
+    }
+    if (it != _mapTooltipSections.end()) return false;
 
-        auto reachable = _tracker->isReachable(loc, sec);
-        if (reachable == AccessibilityLevel::NORMAL) {
-            hasReachable = true;
-        } else if (reachable == AccessibilityLevel::NONE) {
-            hasUnreachable = true;
-        } else if (reachable == AccessibilityLevel::INSPECT) {
-            hasCheckable = true;
-        } else {
-            hasGlitchedReachable = true;
+    // sizes don't change, so no relayout is required; hosted items update through _items
+    if (_mapTooltipTitle)
+        _mapTooltipTitle->setTextColor(locationTooltipColor(_locationStates->getState(_mapTooltipName)));
+    for (const auto& pair: matched) {
+        auto& sec = *pair.second;
+        if (pair.first->label)
+            pair.first->label->setTextColor(sectionTooltipColor(_tracker->isReachable(loc, sec), false));
+        if (pair.first->icon) {
+            pair.first->icon->setStage(sec.getItemCleared() >= sec.getItemCount() ? 1 : 0, 0);
+            setLocationIconOverlay(pair.first->icon, sec);
         }
-        if (hasReachable && hasUnreachable && hasGlitchedReachable && hasCheckable) break;
     }
-    if (!hasVisible) return -1;
-    uint8_t res = (hasCheckable?(1<<3):0) |
-                  (hasGlitchedReachable?(1<<2):0) |
-                  (hasUnreachable?(1<<1):0) |
-                  (hasReachable?(1<<0):0);
-    return res;
+    return true;
 }
 
 
+
 } // namespace
@@ -6,11 +6,15 @@
 #include "../uilib/tabs.h"
 #include "../uilib/fontstore.h"
 #include "../uilib/scrollvbox.h"
+#include "../uilib/label.h"
+#include "../uilib/widgetpool.h"
 #include "mapwidget.h"
 #include "item.h"
 #include "../core/tracker.h"
+#include "../core/locationstates.h"
 #include <list>
 #include <map>
+#include <set>
 
 namespace Ui {
 
@@ -36,6 +40,7 @@ public:
 
 protected:
     Tracker* _tracker;
+    LocationStates* _locationStates; // shared with other views of _tracker
     std::string _layoutRoot;
     std::list<std::string> _layoutRefs;
     bool _relayoutRequired = false;
@@ -47,6 +52,16 @@ protected:
     MapWidget *_mapTooltipOwner = nullptr;
     std::string _mapTooltipName;
     std::map<std::string, int> _mapTooltipScrollOffsets;
+    // widgets of the tooltip that change with location state
+    struct MapTooltipSection {
+        std::string name;
+        std::list<std::string> hostedItems;
+        Label* label = nullptr;
+        Item* icon = nullptr; // nullptr if section has no chests
+    };
+    Label* _mapTooltipTitle = nullptr;
+    std::list<MapTooltipSection> _mapTooltipSections;
+    WidgetPool _tooltipPool; // labels and icons of closed tooltips
 
     int _absX=0;
     int _absY=0;
@@ -56,24 +71,51 @@ protected:
     std::list<std::string> _activeTabs;
     std::list< std::pair<std::string,std::string> > _missedHints;
 
+    // widgets in hidden tabs that missed updates, refreshed when shown
+    std::map<Item*, std::string> _staleItems;
+    std::set<MapWidget*> _staleMaps;
+
     bool _hideClearedLocations = false;
     bool _hideUnreachableLocations = false;
 
     int _defaultQuality = -1;
 
+    // widgets built from layout nodes, to reuse unchanged parts of the ui
+    struct BuiltNode {
+        Container* parent;
+        std::list<size_t> keys; // see layoutNodeKey()
+        std::set<std::string> refs; // named layouts used by this subtree
+        bool broken = false; // a child was moved out of it
+    };
+    std::map<Widget*, BuiltNode> _builtNodes;
+    std::multimap<size_t, Widget*> _builtNodesByKey;
+    // old ui during relayout()
+    std::map<Widget*, BuiltNode> _reusableNodes;
+    std::multimap<size_t, Widget*> _reusableNodesByKey;
+    std::set<Widget*> _takenNodes;
+    std::set<std::string>* _buildRefs = nullptr;
+    std::set<std::string> _changedLayouts;
+    bool _fullRebuild = true;
+
     void updateLayout(const std::string& layout);
     void updateState(const std::string& check);
+    void updateItem(Item* w, const ::BaseItem& item);
+    void updateStale();
     void updateLocations();
+    void updateLocations(const std::set<std::string>& changed);
+    void updateMapTooltipState();
 
     size_t addLayoutNodes(Container* container, const std::list<LayoutNode>& nodes, size_t depth=0);
     bool addLayoutNode(Container* container, const LayoutNode& node, size_t depth=0);
+    bool buildLayoutNode(Container* container, const LayoutNode& node, size_t depth);
+    size_t layoutNodeKey(const Container* container, const LayoutNode& node) const;
+    Widget* takeBuiltNode(size_t key, std::set<std::string>& refs);
 
     Item* makeItem(int x, int y, int w, int h, const ::BaseItem& item, int stage1=-1, int stage2=0);
     Item* makeLocationIcon(int x, int y, int w, int h, const std::string& locid, const LocationSection& sec, bool opened, bool compact);
 
     ScrollVBox* makeMapTooltip(const std::string& location, int x, int y);
-
-    int calculateLocationState(const std::string& location);
+    bool updateMapTooltip();
 };
 
 } // namespace Ui
@@ -1,6 +1,7 @@
 #include "button.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include "texturestats.h"
 
 #define SDL_HAS_SCALE_MODE SDL_VERSION_ATLEAST(2, 0, 12)
 
@@ -23,7 +24,7 @@ Button::Button(int x, int y, int w, int h, FONT font, const std::string& text)
 Button::~Button()
 {
     if (_iconSurf) SDL_FreeSurface(_iconSurf);
-    if (_iconTex) SDL_DestroyTexture(_iconTex);
+    if (_iconTex) TextureStats::destroy(_iconTex);
 }
 
 void Button::setText(const std::string& text)
@@ -39,7 +40,7 @@ void Button::setIcon(const void* data, size_t len)
 {
     if (_iconSurf || _iconTex) {
         if (_iconSurf) SDL_FreeSurface(_iconSurf);
-        if (_iconTex) SDL_DestroyTexture(_iconTex);
+        if (_iconTex) TextureStats::destroy(_iconTex);
         _iconTex = nullptr;
         _autoSize.width -= (ICON_SIZE + _padding);
         _minSize.width -= (ICON_SIZE + _padding);
@@ -56,7 +57,8 @@ void Button::render(Renderer renderer, int offX, int offY)
 {
     if (_iconSurf && !_iconTex) {
         SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "2");
-        _iconTex = SDL_CreateTextureFromSurface(renderer, _iconSurf);
+        _iconTex = TextureStats::created(renderer, SDL_CreateTextureFromSurface(renderer, _iconSurf));
+        TextureStats::setEvictable(_iconTex, [this]() { _iconTex = nullptr; });
         SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "");
         if (_iconTex && _iconSurf->w > 0 && _iconSurf->h > 0) {
 #if SDL_HAS_SCALE_MODE
@@ -87,6 +89,7 @@ void Button::render(Renderer renderer, int offX, int offY)
     int x = _padding + (ICON_SIZE - w)/2;
     int y = (_autoSize.height - h)/2;
     SDL_Rect dest = {.x = offX + _pos.left + x, .y = offY + _pos.top + y, .w = w, .h = h};
+    TextureStats::used(_iconTex);
     SDL_RenderCopy(renderer, _iconTex, NULL, &dest);
 
     _autoSize.width -= 2*_padding;
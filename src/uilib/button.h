@@ -21,6 +21,7 @@ public:
     void setIcon(const void* data, size_t len);
     void setState(State state) { _state = state; }
     bool getPressed() const { return _state == State::AUTO ? _autoState : (bool)_state; }
+    virtual bool isRenderCacheable() const override { return false; } // hover is not tracked
 
     static constexpr int ICON_SIZE = 17;
 
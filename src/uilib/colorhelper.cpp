@@ -0,0 +1,247 @@
+#include "colorhelper.h"
+
+// Vectorized pixel kernels for 32bit surfaces.
+// SSE2 and AVX2 variants are compiled with target attributes and selected at
+// runtime, everything else (non-x86, wasm, other greyscale modes) uses the
+// scalar code. All variants have to produce bit-identical output.
+
+#if (defined __x86_64__ || defined __i386__) && (defined __GNUC__ || defined __clang__) \
+        && !defined __EMSCRIPTEN__ && !defined COLORHELPER_NO_SIMD
+#   define COLORHELPER_X86
+#   include <immintrin.h>
+#endif
+
+
+namespace {
+
+enum class SimdLevel {
+    NONE,
+    SSE2,
+    AVX2,
+};
+
+SimdLevel simdLimit = SimdLevel::AVX2;
+
+SimdLevel getSimdLevel()
+{
+#ifdef COLORHELPER_X86
+    static SimdLevel level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+        return SimdLevel::NONE;
+    }();
+    return (level < simdLimit) ? level : simdLimit;
+#else
+    return SimdLevel::NONE;
+#endif
+}
+
+struct Format32 {
+    uint32_t keep; // bits that are not touched, i.e. alpha or padding
+    int rshift;
+    int gshift;
+    int bshift;
+};
+
+bool getFormat32(const SDL_PixelFormat* fmt, Format32& res)
+{
+    // only 8 bits per color channel are supported by the vectorized kernels
+    if (fmt->BytesPerPixel != 4 || fmt->palette)
+        return false;
+    if (fmt->Rloss || fmt->Gloss || fmt->Bloss)
+        return false;
+    if (fmt->Rmask != (0xffu << fmt->Rshift) ||
+            fmt->Gmask != (0xffu << fmt->Gshift) ||
+            fmt->Bmask != (0xffu << fmt->Bshift))
+        return false;
+    res.keep = ~(fmt->Rmask | fmt->Gmask | fmt->Bmask);
+    res.rshift = fmt->Rshift;
+    res.gshift = fmt->Gshift;
+    res.bshift = fmt->Bshift;
+    return true;
+}
+
+#if defined BW_LUMINOSITY
+void greyscaleRowScalar(uint32_t* px, int n, const Format32& f, bool darken)
+{
+    for (int x=0; x<n; x++) {
+        uint32_t pixel = px[x];
+        uint32_t w = makeGreyscale((uint8_t)(pixel >> f.rshift),
+                                   (uint8_t)(pixel >> f.gshift),
+                                   (uint8_t)(pixel >> f.bshift), darken);
+        px[x] = (pixel & f.keep) | (w << f.rshift) | (w << f.gshift) | (w << f.bshift);
+    }
+}
+
+#ifdef COLORHELPER_X86
+// NOTE: every 32bit lane holds a value <0x10000, so 16bit multiplies are
+//       enough and the upper half of each lane stays 0.
+//       x/3 == (x*43691)>>17 for x<=51001 and x/100 == (x*5243)>>19 for x<=25550
+//       which covers the full range of the luminosity calculation.
+
+__attribute__((target("sse2")))
+void greyscaleRowSSE2(uint32_t* px, int n, const Format32& f, bool darken)
+{
+    const __m128i mask8 = _mm_set1_epi32(0xff);
+    const __m128i keep = _mm_set1_epi32((int)f.keep);
+    const __m128i kr = _mm_set1_epi32(21);
+    const __m128i kg = _mm_set1_epi32(72);
+    const __m128i kb = _mm_set1_epi32(7);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i div3 = _mm_set1_epi32(43691);
+    const __m128i round = _mm_set1_epi32(50);
+    const __m128i div100 = _mm_set1_epi32(5243);
+    const __m128i rs = _mm_cvtsi32_si128(f.rshift);
+    const __m128i gs = _mm_cvtsi32_si128(f.gshift);
+    const __m128i bs = _mm_cvtsi32_si128(f.bshift);
+    int x = 0;
+    for (; x+4 <= n; x+=4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(px+x));
+        __m128i r = _mm_and_si128(_mm_srl_epi32(p, rs), mask8);
+        __m128i g = _mm_and_si128(_mm_srl_epi32(p, gs), mask8);
+        __m128i b = _mm_and_si128(_mm_srl_epi32(p, bs), mask8);
+        __m128i v = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi16(r, kr),
+                _mm_mullo_epi16(g, kg)), _mm_mullo_epi16(b, kb));
+        if (darken) {
+            v = _mm_add_epi32(_mm_add_epi32(v, v), one);
+            v = _mm_srli_epi32(_mm_mulhi_epu16(v, div3), 1);
+        }
+        v = _mm_srli_epi32(_mm_mulhi_epu16(_mm_add_epi32(v, round), div100), 3);
+        __m128i res = _mm_and_si128(p, keep);
+        res = _mm_or_si128(res, _mm_sll_epi32(v, rs));
+        res = _mm_or_si128(res, _mm_sll_epi32(v, gs));
+        res = _mm_or_si128(res, _mm_sll_epi32(v, bs));
+        _mm_storeu_si128((__m128i*)(px+x), res);
+    }
+    greyscaleRowScalar(px+x, n-x, f, darken);
+}
+
+__attribute__((target("avx2")))
+void greyscaleRowAVX2(uint32_t* px, int n, const Format32& f, bool darken)
+{
+    const __m256i mask8 = _mm256_set1_epi32(0xff);
+    const __m256i keep = _mm256_set1_epi32((int)f.keep);
+    const __m256i kr = _mm256_set1_epi32(21);
+    const __m256i kg = _mm256_set1_epi32(72);
+    const __m256i kb = _mm256_set1_epi32(7);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i div3 = _mm256_set1_epi32(43691);
+    const __m256i round = _mm256_set1_epi32(50);
+    const __m256i div100 = _mm256_set1_epi32(5243);
+    const __m128i rs = _mm_cvtsi32_si128(f.rshift);
+    const __m128i gs = _mm_cvtsi32_si128(f.gshift);
+    const __m128i bs = _mm_cvtsi32_si128(f.bshift);
+    int x = 0;
+    for (; x+8 <= n; x+=8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(px+x));
+        __m256i r = _mm256_and_si256(_mm256_srl_epi32(p, rs), mask8);
+        __m256i g = _mm256_and_si256(_mm256_srl_epi32(p, gs), mask8);
+        __m256i b = _mm256_and_si256(_mm256_srl_epi32(p, bs), mask8);
+        __m256i v = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi16(r, kr),
+                _mm256_mullo_epi16(g, kg)), _mm256_mullo_epi16(b, kb));
+        if (darken) {
+            v = _mm256_add_epi32(_mm256_add_epi32(v, v), one);
+            v = _mm256_srli_epi32(_mm256_mulhi_epu16(v, div3), 1);
+        }
+        v = _mm256_srli_epi32(_mm256_mulhi_epu16(_mm256_add_epi32(v, round), div100), 3);
+        __m256i res = _mm256_and_si256(p, keep);
+        res = _mm256_or_si256(res, _mm256_sll_epi32(v, rs));
+        res = _mm256_or_si256(res, _mm256_sll_epi32(v, gs));
+        res = _mm256_or_si256(res, _mm256_sll_epi32(v, bs));
+        _mm256_storeu_si256((__m256i*)(px+x), res);
+    }
+    greyscaleRowSSE2(px+x, n-x, f, darken);
+}
+#endif // COLORHELPER_X86
+#endif // BW_LUMINOSITY
+
+void replaceRowScalar(uint32_t* px, int n, uint32_t key, uint32_t value)
+{
+    for (int x=0; x<n; x++) {
+        if (px[x] == key) px[x] = value;
+    }
+}
+
+#ifdef COLORHELPER_X86
+__attribute__((target("sse2")))
+void replaceRowSSE2(uint32_t* px, int n, uint32_t key, uint32_t value)
+{
+    const __m128i k = _mm_set1_epi32((int)key);
+    const __m128i v = _mm_set1_epi32((int)value);
+    int x = 0;
+    for (; x+4 <= n; x+=4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(px+x));
+        __m128i m = _mm_cmpeq_epi32(p, k);
+        p = _mm_or_si128(_mm_andnot_si128(m, p), _mm_and_si128(m, v));
+        _mm_storeu_si128((__m128i*)(px+x), p);
+    }
+    replaceRowScalar(px+x, n-x, key, value);
+}
+
+__attribute__((target("avx2")))
+void replaceRowAVX2(uint32_t* px, int n, uint32_t key, uint32_t value)
+{
+    const __m256i k = _mm256_set1_epi32((int)key);
+    const __m256i v = _mm256_set1_epi32((int)value);
+    int x = 0;
+    for (; x+8 <= n; x+=8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(px+x));
+        __m256i m = _mm256_cmpeq_epi32(p, k);
+        p = _mm256_blendv_epi8(p, v, m);
+        _mm256_storeu_si256((__m256i*)(px+x), p);
+    }
+    replaceRowSSE2(px+x, n-x, key, value);
+}
+#endif // COLORHELPER_X86
+
+} // namespace
+
+
+bool makeGreyscale32(SDL_Surface* surf, bool darken)
+{
+#if defined BW_LUMINOSITY
+    Format32 f;
+    if (!getFormat32(surf->format, f))
+        return false;
+    auto kernel = greyscaleRowScalar;
+#ifdef COLORHELPER_X86
+    switch (getSimdLevel()) {
+        case SimdLevel::AVX2: kernel = greyscaleRowAVX2; break;
+        case SimdLevel::SSE2: kernel = greyscaleRowSSE2; break;
+        default: break;
+    }
+#endif
+    uint8_t* data = (uint8_t*)surf->pixels;
+    for (int y=0; y<surf->h; y++) {
+        kernel((uint32_t*)(data + y * surf->pitch), surf->w, f, darken);
+    }
+    return true;
+#else
+    (void)surf;
+    (void)darken;
+    return false; // only luminosity is vectorized
+#endif
+}
+
+int setColorHelperSimdLimit(int limit)
+{
+    simdLimit = (limit <= 0) ? SimdLevel::NONE : (limit == 1) ? SimdLevel::SSE2 : SimdLevel::AVX2;
+    return (int)getSimdLevel();
+}
+
+void replaceColor32(SDL_Surface* surf, uint32_t key, uint32_t value)
+{
+    auto kernel = replaceRowScalar;
+#ifdef COLORHELPER_X86
+    switch (getSimdLevel()) {
+        case SimdLevel::AVX2: kernel = replaceRowAVX2; break;
+        case SimdLevel::SSE2: kernel = replaceRowSSE2; break;
+        default: break;
+    }
+#endif
+    uint8_t* data = (uint8_t*)surf->pixels;
+    for (int y=0; y<surf->h; y++) {
+        kernel((uint32_t*)(data + y * surf->pitch), surf->w, key, value);
+    }
+}
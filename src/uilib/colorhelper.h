@@ -10,6 +10,15 @@
 #define BW_LUMINOSITY // modes for greyscale are BW_LUMINOSITY, BW_LIGHTNESS and BW_AVERAGE
 
 
+// vectorized kernels for 32bit surfaces, see colorhelper.cpp
+// surface has to be locked; returns false if the pixel format is not supported
+bool makeGreyscale32(SDL_Surface* surf, bool darken);
+void replaceColor32(SDL_Surface* surf, uint32_t key, uint32_t value);
+// limits the kernels above to compare them, see bench/colorhelper.cpp
+// 0 = scalar, 1 = SSE2, 2 = AVX2; returns the level that will actually be used
+int setColorHelperSimdLimit(int limit);
+
+
 static Uint32 getPixel(SDL_Surface* surf, unsigned x, unsigned y)
 {
     unsigned Bpp = surf->format->BytesPerPixel;
@@ -105,6 +114,8 @@ static inline void uintToBytes(uint32_t d, uint8_t* b, const uint8_t bytespp)
 static inline void _makeGreyscaleRGB(SDL_Surface *surf, bool darken)
 {
     const uint8_t bytespp = surf->format->BytesPerPixel;
+    if (bytespp == 4 && makeGreyscale32(surf, darken))
+        return;
     uint8_t* data = (uint8_t*)surf->pixels;
     auto fmt = surf->format;
     for (int y=0; y<surf->h; y++) {
@@ -198,12 +209,7 @@ static SDL_Surface *makeTransparent(SDL_Surface *surf, uint8_t r, uint8_t g, uin
             SDL_SetSurfaceBlendMode(surf, SDL_BLENDMODE_BLEND);
             if (SDL_LockSurface(surf) == 0) {
                 uint32_t key = SDL_MapRGB(surf->format, r, g, b);
-                for (int y=0; y<surf->h; y++) {
-                    uint32_t* vals = (uint32_t*)((uint8_t*)surf->pixels + y*surf->pitch);
-                    for (int x=0; x<surf->w; x++) {
-                        if (vals[x] == key) vals[x] = 0;
-                    }
-                }
+                replaceColor32(surf, key, 0);
                 SDL_UnlockSurface(surf);
             } else {
                 fprintf(stderr, "Could not lock surface to make transparent: %s\n",
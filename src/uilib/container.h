@@ -2,7 +2,12 @@
 #define _UILIB_CONTAINER_H
 
 #include "widget.h"
+#include "texturestats.h"
+#include "../core/perfstats.h"
 #include <deque>
+#include <vector>
+#include <map>
+#include <string>
 #include <algorithm>
 
 #ifndef NDEBUG
@@ -16,10 +21,16 @@ class Container : public Widget {
 public:
     virtual ~Container() {
         clearChildren();
+        if (_renderCache) TextureStats::destroy(_renderCache);
+        _renderCache = nullptr;
     }
     virtual void addChild(Widget* child) {
         if (!child) return;
         _children.push_back(child);
+        setParent(child, this);
+        invalidate();
+        auto container = dynamic_cast<Container*>(child);
+        if (container && container->needsLayout()) markLayoutDirty();
         if (child->getHGrow()>_hGrow) _hGrow = child->getHGrow();
         if (child->getVGrow()>_vGrow) _vGrow = child->getVGrow();
     }
@@ -30,6 +41,8 @@ public:
             _hoverChild = nullptr;
         }
         _children.erase(std::remove(_children.begin(), _children.end(), child), _children.end());
+        setParent(child, nullptr);
+        invalidate();
         if ((_hGrow>0 && child->getHGrow()>=_hGrow) || (_vGrow>0 && child->getVGrow()>=_vGrow)) {
             int oldHGrow = _hGrow; int oldVGrow = _vGrow;
             _hGrow = 0; _vGrow = 0;
@@ -49,6 +62,7 @@ public:
             delete child;
         }
         _children.clear();
+        invalidate();
     }
     virtual void raiseChild(Widget* child) {
         if (!child) return;
@@ -72,12 +86,58 @@ public:
             SDL_RenderFillRect(renderer, &r);
         }
         // TODO: background image
+        SDL_Rect cull;
+        bool doCull = getCullRect(renderer, cull);
         for (auto& child: _children)
-            if (child->getVisible())
-                child->render(renderer, offX+_pos.left, offY+_pos.top);
+            if (child->getVisible() && (!doCull || isInRect(child, offX+_pos.left, offY+_pos.top, cull)))
+                renderChild(renderer, child, offX+_pos.left, offY+_pos.top);
     }
     const std::deque<Widget*> getChildren() const { return _children; }
 
+    // Caches the rendered container in a texture that is redrawn only after
+    // invalidate() was called for it or a child. Only used if all children are
+    // cacheable, otherwise the container is rendered as usual.
+    void setRenderCache(bool enable) {
+        if (enable == _renderCacheEnabled) return;
+        _renderCacheEnabled = enable;
+        if (!enable && _renderCache) {
+            TextureStats::destroy(_renderCache);
+            _renderCache = nullptr;
+        }
+        invalidate();
+    }
+    virtual bool hasRenderCache() const override { return _renderCacheEnabled; }
+    virtual bool isRenderCacheable() const override {
+        for (const auto child: _children)
+            if (!child->isRenderCacheable()) return false;
+        return true;
+    }
+
+    // Containers don't lay out when children are added or resized, or when
+    // they are resized themselves. They call invalidateLayout() instead, which
+    // marks the path to the root, and pending layouts are resolved once per
+    // frame by Window::render() or when the container is added to a parent.
+    // flushLayout() runs pending layouts of this subtree now. Children are
+    // laid out before their parent, and a parent is laid out again if the
+    // min size of a child changed. Layout passes are counted in PerfStats.
+    void flushLayout() {
+        for (int i=0; i<MAX_LAYOUT_ROUNDS && needsLayout(); i++) {
+            if (_layoutDirty) {
+                _layoutDirty = false;
+                for (auto child: _children) {
+                    auto container = dynamic_cast<Container*>(child);
+                    if (container && container->needsLayout()) container->flushLayout();
+                }
+            }
+            if (_layoutPending) {
+                Size oldMinSize = _minSize;
+                doLayout();
+                if (_minSize != oldMinSize && _parent) static_cast<Container*>(_parent)->invalidateLayout();
+            }
+        }
+    }
+    bool needsLayout() const { return _layoutPending || _layoutDirty; }
+
     virtual bool isHover(Widget* w) const override {
         return (w == this || (_hoverChild && _hoverChild->isHover(w)));
     }
@@ -119,6 +179,176 @@ public:
 protected:
     std::deque<Widget*> _children;
     Widget* _hoverChild = nullptr;
+    bool _layoutPending = false; // this container has to be laid out
+    bool _layoutDirty = false; // a child container has to be laid out
+
+    struct ClipState {
+        bool enabled;
+        SDL_Rect rect;
+    };
+    static inline std::vector<ClipState> _clipStack;
+
+    bool _renderCacheEnabled = false;
+    bool _renderCacheable = false;
+    SDL_Texture* _renderCache = nullptr;
+
+    // limit for layouts that resize themselves or their children again
+    static constexpr int MAX_LAYOUT_ROUNDS = 8;
+
+    // schedules doLayout(), see flushLayout()
+    void invalidateLayout() {
+        _layoutPending = true;
+        if (_parent) static_cast<Container*>(_parent)->markLayoutDirty();
+    }
+    void markLayoutDirty() {
+        for (Container* c = this; c && !c->_layoutDirty; c = static_cast<Container*>(c->_parent))
+            c->_layoutDirty = true;
+    }
+    // has to be called at the start of every layout pass
+    void beginLayoutPass() {
+        _layoutPending = false;
+        PerfStats::countLayoutPass();
+    }
+    // runs the deferred layout pass
+    virtual void doLayout() {
+        _layoutPending = false;
+    }
+    // renders child from its render cache if it has one, see setRenderCache()
+    static void renderChild(Renderer renderer, Widget* child, int offX, int offY) {
+        if (child->hasRenderCache())
+            static_cast<Container*>(child)->renderCached(renderer, offX, offY);
+        else
+            child->render(renderer, offX, offY);
+    }
+    void renderCached(Renderer renderer, int offX, int offY) {
+        SDL_Rect dst = { offX+_pos.left-_margin.left, offY+_pos.top-_margin.top,
+                         _size.width+_margin.left+_margin.right, _size.height+_margin.top+_margin.bottom };
+        // Rendering into the cache results in premultiplied alpha, which needs
+        // a custom blend mode. Renderers without those (i.e. software) get the
+        // background drawn outside of the cache and the content blended as is,
+        // which makes anti-aliased edges on translucent parts slightly darker.
+        bool opaque = _backgroundColor.a == 0xff;
+        bool premultiplied = !opaque && supportsPremultipliedBlend(renderer);
+        bool straight = !opaque && !premultiplied;
+        if (!_renderCacheValid) {
+            // content or children changed, check if we can (still) cache
+            _renderCacheable = dst.w > 0 && dst.h > 0 && isRenderCacheable() && SDL_RenderTargetSupported(renderer);
+            _renderCacheValid = true; // until something changes, including during the render below
+            int w = 0, h = 0;
+            if (_renderCache && (!_renderCacheable ||
+                    SDL_QueryTexture(_renderCache, nullptr, nullptr, &w, &h) != 0 || w != dst.w || h != dst.h)) {
+                TextureStats::destroy(_renderCache);
+                _renderCache = nullptr;
+            }
+            if (_renderCacheable && !_renderCache) {
+                _renderCache = TextureStats::created(renderer, SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                        SDL_TEXTUREACCESS_TARGET, dst.w, dst.h));
+                TextureStats::setEvictable(_renderCache, [this]() {
+                    _renderCache = nullptr;
+                    _renderCacheValid = false;
+                });
+            }
+            SDL_BlendMode mode = opaque ? SDL_BLENDMODE_NONE :
+                    premultiplied ? premultipliedBlendMode() : SDL_BLENDMODE_BLEND;
+            if (_renderCache && SDL_SetTextureBlendMode(_renderCache, mode) != 0) {
+                TextureStats::destroy(_renderCache);
+                _renderCache = nullptr;
+            }
+            if (_renderCache) {
+                // NOTE: switching targets resets the clip rect
+                SDL_Rect clip;
+                bool clipped = SDL_RenderIsClipEnabled(renderer);
+                if (clipped) SDL_RenderGetClipRect(renderer, &clip);
+                auto oldTarget = SDL_GetRenderTarget(renderer);
+                SDL_SetRenderTarget(renderer, _renderCache);
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+                SDL_RenderClear(renderer);
+                auto bg = _backgroundColor;
+                if (straight) _backgroundColor.a = 0; // drawn below, don't invalidate()
+                render(renderer, -(_pos.left-_margin.left), -(_pos.top-_margin.top));
+                _backgroundColor = bg;
+                SDL_SetRenderTarget(renderer, oldTarget);
+                if (clipped) SDL_RenderSetClipRect(renderer, &clip);
+            }
+        }
+        if (_renderCache) {
+            if (straight && _backgroundColor.a > 0) {
+                const auto& c = _backgroundColor;
+                SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+                SDL_RenderFillRect(renderer, &dst);
+            }
+            TextureStats::used(_renderCache);
+            SDL_RenderCopy(renderer, _renderCache, nullptr, &dst);
+        } else
+            render(renderer, offX, offY);
+    }
+    static SDL_BlendMode premultipliedBlendMode() {
+        return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                          SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    }
+    // probes custom blend mode support once per renderer backend
+    static bool supportsPremultipliedBlend(Renderer renderer) {
+        static std::map<std::string, bool> supported; // by renderer name
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(renderer, &info) != 0 || !info.name) return false;
+        auto it = supported.find(info.name);
+        if (it != supported.end()) return it->second;
+        bool res = false;
+        auto tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1);
+        if (tex) {
+            res = SDL_SetTextureBlendMode(tex, premultipliedBlendMode()) == 0;
+            SDL_DestroyTexture(tex);
+        }
+        supported[info.name] = res;
+        return res;
+    }
+
+    // Children outside of the renderer's clip rect (or viewport if clipping
+    // is disabled) are not rendered. Containers that show only part of their
+    // children set a clip rect with pushClipRect(), so this applies to the
+    // whole subtree.
+    static constexpr int CULL_SLACK = 2; // drop shadows may be outside of a widget
+    static bool getCullRect(Renderer renderer, SDL_Rect& rect) {
+        if (SDL_RenderIsClipEnabled(renderer)) SDL_RenderGetClipRect(renderer, &rect);
+        else SDL_RenderGetViewport(renderer, &rect);
+        return rect.w > 0 && rect.h > 0;
+    }
+    static bool isInRect(const Widget* w, int offX, int offY, const SDL_Rect& rect) {
+        // NOTE: this uses the layout box, getMinX() etc. may only be valid after rendering
+        const auto& m = w->getMargin();
+        int x1 = offX + w->getLeft() - m.left - CULL_SLACK;
+        int y1 = offY + w->getTop() - m.top - CULL_SLACK;
+        int x2 = offX + w->getLeft() + w->getWidth() + m.right + CULL_SLACK;
+        int y2 = offY + w->getTop() + w->getHeight() + m.bottom + CULL_SLACK;
+        return x2 > rect.x && y2 > rect.y && x1 < rect.x + rect.w && y1 < rect.y + rect.h;
+    }
+    // intersects the clip rect with r, returns false if nothing would be visible.
+    // popClipRect() has to be called after rendering if this returned true.
+    static bool pushClipRect(Renderer renderer, const SDL_Rect& r) {
+        SDL_Rect clip = r;
+        ClipState old = { SDL_RenderIsClipEnabled(renderer) == SDL_TRUE, {0,0,0,0} };
+        if (old.enabled) {
+            SDL_RenderGetClipRect(renderer, &old.rect);
+            if (!SDL_IntersectRect(&old.rect, &r, &clip)) return false;
+        } else if (r.w < 1 || r.h < 1) {
+            return false;
+        }
+        _clipStack.push_back(old);
+        SDL_RenderSetClipRect(renderer, &clip);
+        return true;
+    }
+    static void popClipRect(Renderer renderer) {
+        if (_clipStack.empty()) return;
+        auto old = _clipStack.back();
+        _clipStack.pop_back();
+        SDL_RenderSetClipRect(renderer, old.enabled ? &old.rect : nullptr);
+    }
+
+    // children have to be laid out before their size is used
+    static void flushChildLayout(Widget* child) {
+        auto container = dynamic_cast<Container*>(child);
+        if (container && container->needsLayout()) container->flushLayout();
+    }
     
     Container(int x=0, int y=0, int w=0, int h=0)
         : Widget(x,y,w,h)
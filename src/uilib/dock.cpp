@@ -16,9 +16,10 @@ void Dock::addChild(Widget* w)
 }
 void Dock::addChild(Widget* w, Direction dir)
 {
+    flushChildLayout(w);
     Container::addChild(w);
     _docks.push_back(dir);
-    relayout();
+    invalidateLayout();
 }
 void Dock::removeChild(Widget* w)
 {
@@ -29,7 +30,7 @@ void Dock::removeChild(Widget* w)
         if (*childIt == w) {
             _docks.erase(dockIt);
             Container::removeChild(w);
-            relayout();
+            invalidateLayout();
             break;
         }
     }
@@ -43,7 +44,7 @@ void Dock::setDock(int index, Direction dir)
             if (index==0) {
                 if (*it != dir) {
                     *it = dir;
-                    relayout();
+                    invalidateLayout();
                 }
                 break;
             }
@@ -53,7 +54,7 @@ void Dock::setDock(int index, Direction dir)
             if (index==0) {
                 if (*it != dir) {
                     *it = dir;
-                    relayout();
+                    invalidateLayout();
                 }
                 break;
             }
@@ -99,6 +100,7 @@ void Dock::relayout()
     // 1. set hgrow/vgrow and minsize to signal parent based on children and dock options
     // 2. actually layout children based on (current) size
     // TODO: implement this better
+    beginLayoutPass();
     bool isHorizontal = false;
     bool isVertical = false;
     int nUndefined = 0; // number of floaters
@@ -268,13 +270,18 @@ void Dock::relayout()
     
 }
 
+void Dock::doLayout()
+{
+    relayout();
+}
+
 void Dock::setSize(Size size)
 {
     if (size.width < _minSize.width) size.width = _minSize.width;
     if (size.height < _minSize.height) size.height = _minSize.height;
     if (size == _size) return;
     Widget::setSize(size);
-    relayout();
+    invalidateLayout();
 }
 
 } // namespace
@@ -19,6 +19,7 @@ public:
     virtual void setSize(Size size) override;
 protected:
     void relayout();
+    virtual void doLayout() override;
     std::list<Direction> _docks;
     bool _preferHorizontal;
 };
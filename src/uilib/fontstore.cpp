@@ -1,5 +1,6 @@
 #include "fontstore.h"
 #include "../core/assets.h"
+#include "glyphatlas.h"
 
 
 namespace Ui {
@@ -10,6 +11,7 @@ FontStore::~FontStore()
 {
     for (const auto& namepair: _store) {
         for (const auto& sizepair: namepair.second) {
+            GlyphAtlas::releaseFont(sizepair.second);
             TTF_CloseFont(sizepair.second);
         }
     }
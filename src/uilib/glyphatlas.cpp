@@ -0,0 +1,231 @@
+#include "glyphatlas.h"
+#include "texturestats.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+
+namespace Ui {
+
+std::map<std::pair<Renderer, GlyphAtlas::FONT>, GlyphAtlas*> GlyphAtlas::_atlases;
+unsigned GlyphAtlas::_generation = 0;
+
+static uint32_t nextCodepoint(const char*& p)
+{
+    // decode one UTF-8 sequence, returns 0xfffd for invalid sequences
+    uint8_t c = (uint8_t)*p++;
+    if (c < 0x80) return c;
+    int n = (c >= 0xf0) ? 3 : (c >= 0xe0) ? 2 : (c >= 0xc0) ? 1 : -1;
+    if (n < 0) return 0xfffd;
+    uint32_t res = c & (0x3f >> n);
+    for (int i=0; i<n; i++) {
+        if (((uint8_t)*p & 0xc0) != 0x80) return 0xfffd;
+        res = (res << 6) | ((uint8_t)*p++ & 0x3f);
+    }
+    return res;
+}
+
+GlyphAtlas* GlyphAtlas::get(Renderer renderer, FONT font)
+{
+    if (!renderer || !font) return nullptr;
+    auto key = std::make_pair(renderer, font);
+    auto it = _atlases.find(key);
+    if (it != _atlases.end()) return it->second;
+    auto atlas = new GlyphAtlas(renderer, font);
+    _atlases[key] = atlas;
+    return atlas;
+}
+
+void GlyphAtlas::releaseFont(FONT font)
+{
+    _generation++;
+    for (auto it = _atlases.begin(); it != _atlases.end();) {
+        if (it->first.second == font) {
+            delete it->second;
+            it = _atlases.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void GlyphAtlas::releaseRenderer(Renderer renderer)
+{
+    _generation++;
+    for (auto it = _atlases.begin(); it != _atlases.end();) {
+        if (it->first.first == renderer) {
+            delete it->second;
+            it = _atlases.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool GlyphAtlas::canRender(const std::string& text)
+{
+    // latin scripts without combining marks look the same glyph by glyph
+    const char* p = text.c_str();
+    while (*p) {
+        uint32_t c = nextCodepoint(p);
+        if (c == '\n' || c == '\r') continue;
+        if (c < 0x20 || c >= 0x300 || (c >= 0x7f && c < 0xa0)) return false;
+    }
+    return true;
+}
+
+GlyphAtlas::GlyphAtlas(Renderer renderer, FONT font)
+    : _renderer(renderer), _font(font)
+{
+    _lineHeight = TTF_FontHeight(font);
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    for (auto page: _pages)
+        TextureStats::destroy(page);
+    _pages.clear();
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::getGlyph(uint16_t c)
+{
+    auto it = _glyphs.find(c);
+    if (it != _glyphs.end()) return &it->second;
+
+    Glyph glyph = {{0,0,0,0}, 0, 0, 0};
+    int minx=0, maxx=0, miny=0, maxy=0, advance=0;
+    if (TTF_GlyphMetrics(_font, c, &minx, &maxx, &miny, &maxy, &advance) == 0) {
+        glyph.advance = advance;
+        glyph.offX = (minx < 0) ? minx : 0;
+    }
+    SDL_Surface* surf = (c == ' ') ? nullptr : TTF_RenderGlyph_Blended(_font, c, {255, 255, 255, 255});
+    if (surf && surf->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        auto old = surf;
+        surf = SDL_ConvertSurfaceFormat(old, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(old);
+    }
+    if (surf && surf->w > 0 && surf->h > 0 && surf->w < PAGE_SIZE && surf->h < PAGE_SIZE) {
+        // find space, 1px padding to avoid bleeding when scaling
+        if (!_pages.empty() && _shelfX + surf->w >= PAGE_SIZE) {
+            _shelfX = 0;
+            _shelfY += _shelfH + 1;
+            _shelfH = 0;
+        }
+        if (_pages.empty() || _shelfY + surf->h >= PAGE_SIZE) {
+            SDL_Texture* page = TextureStats::created(_renderer, SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888,
+                    SDL_TEXTUREACCESS_STATIC, PAGE_SIZE, PAGE_SIZE));
+            if (page) {
+                std::vector<uint32_t> empty(PAGE_SIZE*PAGE_SIZE, 0);
+                SDL_UpdateTexture(page, nullptr, empty.data(), PAGE_SIZE*4);
+                SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+                _pages.push_back(page);
+            } else {
+                fprintf(stderr, "GlyphAtlas: could not create texture: %s\n", SDL_GetError());
+            }
+            _shelfX = 0;
+            _shelfY = 0;
+            _shelfH = 0;
+        }
+        if (!_pages.empty()) {
+            glyph.src = { _shelfX, _shelfY, surf->w, surf->h };
+            glyph.page = _pages.size() - 1;
+            SDL_UpdateTexture(_pages.back(), &glyph.src, surf->pixels, surf->pitch);
+            _shelfX += surf->w + 1;
+            if (surf->h > _shelfH) _shelfH = surf->h;
+        }
+    }
+    if (surf) SDL_FreeSurface(surf);
+    return &(_glyphs[c] = glyph);
+}
+
+Size GlyphAtlas::layout(const std::string& text, Label::HAlign halign, std::vector<GlyphQuad>& quads)
+{
+    // same line spacing as RenderText
+    constexpr int linespace = 1;
+    quads.clear();
+    std::vector<std::pair<size_t, int>> lines; // first quad, width
+    int maxW = 0;
+    int y = 0;
+    const char* p = text.c_str();
+    while (true) {
+        int pen = 0, width = 0;
+        uint16_t prev = 0;
+        lines.push_back({quads.size(), 0});
+        while (*p && *p != '\n') {
+            uint32_t c = nextCodepoint(p);
+            if (c == '\r' || c > 0xffff) continue;
+            const Glyph* glyph = getGlyph((uint16_t)c);
+            if (prev) pen += TTF_GetFontKerningSizeGlyphs(_font, prev, (uint16_t)c);
+            if (glyph->src.w) {
+                quads.push_back({glyph->src, {pen + glyph->offX, y, glyph->src.w, glyph->src.h}, glyph->page});
+                if (pen + glyph->offX + glyph->src.w > width) width = pen + glyph->offX + glyph->src.w;
+            }
+            pen += glyph->advance;
+            if (pen > width) width = pen;
+            prev = (uint16_t)c;
+        }
+        lines.back().second = width;
+        if (width > maxW) maxW = width;
+        y += _lineHeight;
+        if (!*p) break;
+        p++; // skip \n
+        y += linespace;
+    }
+    // align lines
+    if (halign != Label::HAlign::LEFT) {
+        for (size_t i=0; i<lines.size(); i++) {
+            size_t end = (i+1 < lines.size()) ? lines[i+1].first : quads.size();
+            int dx = maxW - lines[i].second;
+            if (halign == Label::HAlign::CENTER) dx /= 2;
+            for (size_t j=lines[i].first; j<end; j++)
+                quads[j].dst.x += dx;
+        }
+    }
+    return {maxW, y};
+}
+
+void GlyphAtlas::draw(const std::vector<GlyphQuad>& quads, int x, int y, Widget::Color color, const SDL_Rect* clip)
+{
+    static std::vector<SDL_Vertex> verts;
+    static std::vector<int> indices;
+    SDL_Color c = { color.r, color.g, color.b, color.a };
+    for (size_t page=0; page<_pages.size(); page++) {
+        verts.clear();
+        indices.clear();
+        for (const auto& quad: quads) {
+            if (quad.page != page) continue;
+            SDL_Rect src = quad.src;
+            SDL_Rect dst = { x + quad.dst.x, y + quad.dst.y, quad.dst.w, quad.dst.h };
+            if (clip) {
+                // clip dst and move src accordingly, quads are not scaled
+                int l = std::max(dst.x, clip->x) - dst.x;
+                int t = std::max(dst.y, clip->y) - dst.y;
+                int r = dst.x + dst.w - std::min(dst.x + dst.w, clip->x + clip->w);
+                int b = dst.y + dst.h - std::min(dst.y + dst.h, clip->y + clip->h);
+                if (l + r >= dst.w || t + b >= dst.h) continue;
+                dst.x += l; src.x += l;
+                dst.y += t; src.y += t;
+                dst.w -= l + r; src.w = dst.w;
+                dst.h -= t + b; src.h = dst.h;
+            }
+            float u0 = (float)src.x / PAGE_SIZE;
+            float v0 = (float)src.y / PAGE_SIZE;
+            float u1 = (float)(src.x + src.w) / PAGE_SIZE;
+            float v1 = (float)(src.y + src.h) / PAGE_SIZE;
+            float x0 = (float)dst.x, y0 = (float)dst.y;
+            float x1 = (float)(dst.x + dst.w), y1 = (float)(dst.y + dst.h);
+            int n = (int)verts.size();
+            verts.push_back({{x0, y0}, c, {u0, v0}});
+            verts.push_back({{x1, y0}, c, {u1, v0}});
+            verts.push_back({{x1, y1}, c, {u1, v1}});
+            verts.push_back({{x0, y1}, c, {u0, v1}});
+            for (int i: {0, 1, 2, 0, 2, 3})
+                indices.push_back(n + i);
+        }
+        if (!verts.empty())
+            SDL_RenderGeometry(_renderer, _pages[page], verts.data(), (int)verts.size(),
+                               indices.data(), (int)indices.size());
+    }
+}
+
+} // namespace Ui
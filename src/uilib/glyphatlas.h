@@ -0,0 +1,77 @@
+#ifndef _UILIB_GLYPHATLAS_H
+#define _UILIB_GLYPHATLAS_H
+
+
+#include <SDL2/SDL_ttf.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "widget.h"
+#include "label.h"
+
+
+namespace Ui {
+
+struct GlyphQuad {
+    SDL_Rect src;
+    SDL_Rect dst; // relative to the top left corner of the text
+    size_t page;
+};
+
+// Caches rasterized glyphs of a font in textures, so text can be drawn as
+// quads without rendering text to a new surface and texture on every change.
+// Glyphs are rendered white and colored when drawing.
+// There is one atlas per renderer and font (FontStore has one font per size).
+class GlyphAtlas final
+{
+public:
+    using FONT = TTF_Font*;
+
+    static GlyphAtlas* get(Renderer renderer, FONT font);
+    // have to be called before the font or renderer gets destroyed
+    static void releaseFont(FONT font);
+    static void releaseRenderer(Renderer renderer);
+    // changes whenever atlases got released, to detect stale pointers from get()
+    static unsigned getGeneration() { return _generation; }
+
+    // returns false if text requires shaping and has to be rendered with TTF
+    static bool canRender(const std::string& text);
+
+    // builds quads for text, returns the size of the text box
+    Size layout(const std::string& text, Label::HAlign halign, std::vector<GlyphQuad>& quads);
+    // draws quads at x,y, only the part inside of clip if it is not null
+    void draw(const std::vector<GlyphQuad>& quads, int x, int y, Widget::Color color,
+              const SDL_Rect* clip=nullptr);
+
+    ~GlyphAtlas();
+
+protected:
+    struct Glyph {
+        SDL_Rect src; // w=0 for glyphs without pixels
+        int offX;
+        int advance;
+        size_t page;
+    };
+
+    static constexpr int PAGE_SIZE = 512;
+
+    GlyphAtlas(Renderer renderer, FONT font);
+    const Glyph* getGlyph(uint16_t c);
+
+    Renderer _renderer;
+    FONT _font;
+    int _lineHeight;
+    std::map<uint16_t, Glyph> _glyphs;
+    std::vector<SDL_Texture*> _pages;
+    // shelf packing in the last page
+    int _shelfX = 0;
+    int _shelfY = 0;
+    int _shelfH = 0;
+
+    static std::map<std::pair<Renderer, FONT>, GlyphAtlas*> _atlases;
+    static unsigned _generation;
+};
+
+} // namespace Ui
+
+#endif // _UILIB_GLYPHATLAS_H
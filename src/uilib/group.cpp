@@ -37,9 +37,11 @@ void Group::render(Renderer renderer, int offX, int offY)
     SDL_SetRenderDrawColor(renderer, TITLE_BG.r, TITLE_BG.g, TITLE_BG.b, TITLE_BG.a);
     SDL_Rect r = { offX+_pos.left, offY+_pos.top, _size.width, TITLE_HEIGHT };
     SDL_RenderFillRect(renderer, &r);
+    SDL_Rect cull;
+    bool doCull = getCullRect(renderer, cull);
     for (auto& child: _children)
-        if (child->getVisible())
-            child->render(renderer, offX+_pos.left, offY+_pos.top);
+        if (child->getVisible() && (!doCull || isInRect(child, offX+_pos.left, offY+_pos.top, cull)))
+            renderChild(renderer, child, offX+_pos.left, offY+_pos.top);
 }
 
 } // namespace
@@ -9,10 +9,13 @@ class HBox : public Container {
 protected:
     int _padding=0;
     int _spacing=2;
+    Size _layoutSize = {-1,-1}; // size children were last laid out for
 public:
     HBox(int x, int y, int w, int h)
         : Container(x,y,w,h) {}
     virtual void addChild(Widget* w) override {
+        flushChildLayout(w);
+        _layoutSize = {-1,-1};
         if (!_children.empty()) {
             auto& last = _children.back();
             int lastRight = last->getLeft() + last->getWidth() + last->getMargin().right;
@@ -27,7 +30,7 @@ public:
                      w->getTop() + w->getHeight() + w->getMargin().bottom + _padding};
             Container::addChild(w);
         }
-        calcMinMax();
+        invalidateLayout();
     }
     // TODO: removeChild: update maxSize and minSize
     virtual void setSize(Size size) override {
@@ -39,7 +42,10 @@ public:
             // this may happen if container<this widget
             size.width = _minSize.width;
         }
+        // children were already sized for this, skip the subtree
+        if (size == _size && size == _layoutSize) return;
         Container::setSize(size);
+        _layoutSize = size;
         // TODO: move this to relayout and run relayout instead
         for (auto child : _children) {
             child->setTop(_padding + child->getMargin().top);
@@ -64,8 +70,15 @@ public:
     virtual void setPadding(int padding) { _padding = padding; } // TODO: relayout?
     virtual void setSpacing(int spacing) { _spacing = spacing; } // TODO: relayout?
 
+protected:
+    virtual void doLayout() override {
+        calcMinMax();
+    }
+
 private:
     void calcMinMax() {
+        beginLayoutPass();
+        _layoutSize = {-1,-1};
         _maxSize = {2*_padding,-1};
         _minSize = {2*_padding,0};
         if (!_children.empty()) {
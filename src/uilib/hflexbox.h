@@ -25,8 +25,9 @@ public:
     HFlexBox(int x, int y, int w, int h, HAlign halign)
         : Container(x,y,w,h), _halign(halign) {}
     virtual void addChild(Widget* w) override {
+        flushChildLayout(w);
         Container::addChild(w);
-        relayout();
+        invalidateLayout();
     }
     // TODO: removeChild: update maxSize and minSize
     virtual void setSize(Size size) override {
@@ -39,12 +40,8 @@ public:
             size.width = _minSize.width;
         }
         if (size == _size) return;
-        if (size.width == _size.width) {
-            Container::setSize(size);
-        } else {
-            Container::setSize(size);
-            relayout();
-        }
+        if (size.width != _size.width) invalidateLayout(); // rows depend on width
+        Container::setSize(size);
     }
     void alignRow(const std::list<Widget*>& row)
     {
@@ -59,7 +56,7 @@ public:
         }
     }
     void relayout() { // TODO: virtual?
-        // TODO: move actual relayout to render stage?
+        beginLayoutPass();
         _minSize.width = 0; // TODO: subscribe to children's onMinWidthChanged instead
         _minSize.height = 0;
         int x=_padding;
@@ -90,6 +87,11 @@ public:
     }
     virtual void setPadding(int padding) { _padding = padding; } // TODO: relayout?
     virtual void setSpacing(int spacing) { _spacing = spacing; } // TODO: relayout?
+
+protected:
+    virtual void doLayout() override {
+        relayout();
+    }
 };
 
 } // namespace Ui
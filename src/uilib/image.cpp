@@ -2,33 +2,40 @@
 #include <stdio.h>
 #include <SDL2/SDL_image.h>
 #include "colorhelper.h"
-
+#include "texturestats.h"
+#include <algorithm>
 
 namespace Ui {
 
 Image::Image(int x, int y, int w, int h, const char* path)
-    : Widget(x,y,w,h), _path(path)
+    : Widget(x,y,w,h), _path(path ? path : "")
 {
-    if (!path || !*path) {
+    if (_path.empty()) {
         _surf = nullptr;
         return;
     }
-    // NOTE: if the app hangs or crashes in IMG_Load, you are probably mixing incompatible DLLs
-    // FIXME: loading images takes a majority of the time to build the UI. Cache it!
-    _surf = IMG_Load(_path.c_str());
-    if (_surf) {
-        _autoSize = {_surf->w, _surf->h};
-        if (w<1 && h<1) {
-            _size.width = _autoSize.width;
-            _size.height = _autoSize.height;
-        } else if (w<1) {
-            _size.width = (_autoSize.width * h + _autoSize.height/2) / _autoSize.height;
-        } else if (h<1) {
-            _size.height = (_autoSize.height * w + _autoSize.width/2) / _autoSize.width;
-        }
+    // read the header first, so large images are not decoded here, see renderTiled()
+    size_t len = 0;
+    void* data = SDL_LoadFile(_path.c_str(), &len);
+    if (data) _data.assign((const char*)data, len);
+    SDL_free(data);
+    int autoW = 0, autoH = 0;
+    if (!ImageDecoder::getSize(_data, autoW, autoH) || (autoW < TILED_MIN_SIZE && autoH < TILED_MIN_SIZE)) {
+        _surf = loadSurface();
+        if (!_surf) return;
+        autoW = _surf->w;
+        autoH = _surf->h;
     }
-    else {
-        fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
+    setAutoSize(autoW, autoH, w, h);
+    if (isTiled()) {
+        // large images are decoded in the background, see renderTiled()
+        if (_surf) SDL_FreeSurface(_surf);
+        _surf = nullptr;
+        loadLevels();
+    } else {
+        // small images are re-loaded from _path when needed again
+        _data.clear();
+        _data.shrink_to_fit();
     }
 }
 Image::Image(int x, int y, int w, int h, const void* data, size_t len)
@@ -38,34 +45,283 @@ Image::Image(int x, int y, int w, int h, const void* data, size_t len)
         _surf = nullptr;
         return;
     }
-    // NOTE: if the app hangs or crashes in IMG_Load_RW, you are probably mixing incompatible DLLs
-    // FIXME: loading images takes a majority of the time to build the UI. Cache it!
-    _surf = IMG_Load_RW(SDL_RWFromMem((void*)data, (int)len), 1);
-    if (_surf) {
-        _autoSize = {_surf->w, _surf->h};
-        if (w<1 && h<1) {
-            _size.width = _autoSize.width;
-            _size.height = _autoSize.height;
-        } else if (w<1) {
-            _size.width = (_autoSize.width * h + _autoSize.height/2) / _autoSize.height;
-        } else if (h<1) {
-            _size.height = (_autoSize.height * w + _autoSize.width/2) / _autoSize.width;
-        }
+    // keep encoded data around so textures can be (re-)created on demand
+    _data.assign((const char*)data, len);
+    int autoW = 0, autoH = 0;
+    if (!ImageDecoder::getSize(_data, autoW, autoH) || (autoW < TILED_MIN_SIZE && autoH < TILED_MIN_SIZE)) {
+        _surf = loadSurface();
+        if (!_surf) return;
+        autoW = _surf->w;
+        autoH = _surf->h;
     }
-    else {
-        fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
+    setAutoSize(autoW, autoH, w, h);
+    if (isTiled()) {
+        // large images are decoded in the background, see renderTiled()
+        if (_surf) SDL_FreeSurface(_surf);
+        _surf = nullptr;
+        loadLevels();
     }
 }
 Image::~Image()
 {
-    if (_tex)   SDL_DestroyTexture(_tex);
-    if (_texBw) SDL_DestroyTexture(_texBw);
+    if (_tex)   TextureStats::destroy(_tex);
+    if (_texBw) TextureStats::destroy(_texBw);
     if (_surf)  SDL_FreeSurface(_surf);
+    freeTiles();
+    freeLevels((int)_levels.size() - 1);
+    _levelJob = nullptr; // dropped by the decoder if still queued
     _tex   = nullptr;
     _texBw = nullptr;
     _surf  = nullptr;
 }
 
+SDL_Surface* Image::loadSurface()
+{
+    // NOTE: if the app hangs or crashes in IMG_Load, you are probably mixing incompatible DLLs
+    // FIXME: loading images takes a majority of the time to build the UI. Cache it!
+    SDL_Surface* surf = nullptr;
+    if (!_data.empty())
+        surf = IMG_Load_RW(SDL_RWFromMem((void*)_data.c_str(), (int)_data.length()), 1);
+    else if (!_path.empty())
+        surf = IMG_Load(_path.c_str());
+    else
+        return nullptr;
+    if (!surf)
+        fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
+    return surf;
+}
+
+void Image::setAutoSize(int autoW, int autoH, int w, int h)
+{
+    _autoSize = {autoW, autoH};
+    if (w<1 && h<1) {
+        _size.width = _autoSize.width;
+        _size.height = _autoSize.height;
+    } else if (w<1) {
+        _size.width = (_autoSize.width * h + _autoSize.height/2) / _autoSize.height;
+    } else if (h<1) {
+        _size.height = (_autoSize.height * w + _autoSize.width/2) / _autoSize.width;
+    }
+}
+
+SDL_Texture* Image::getTexture(Renderer renderer, bool enabled)
+{
+    // textures are created on first use, so the greyscale variant only exists
+    // if it was ever drawn, and variants that were not drawn for a while are
+    // freed to save renderer memory.
+    uint32_t now = SDL_GetTicks();
+    SDL_Texture*& tex = enabled ? _tex : _texBw;
+    SDL_Texture*& other = enabled ? _texBw : _tex;
+    uint32_t& lastUse = enabled ? _texLastUse : _texBwLastUse;
+    uint32_t& otherLastUse = enabled ? _texBwLastUse : _texLastUse;
+    lastUse = now;
+    if (other && now - otherLastUse > TEXTURE_KEEP_TIME) {
+        TextureStats::destroy(other);
+        other = nullptr;
+    }
+    if (tex) return tex;
+
+    SDL_Surface* surf = _surf ? _surf : loadSurface();
+    _surf = nullptr;
+    if (!surf) return nullptr;
+    if (_quality >= 0) {
+        // set Texture filter/quality when creating the texture
+        char q[] = { (char)('0'+_quality), 0 };
+        if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, q)) {
+            printf("Image: could not set scale quality to %s!\n", q);
+        }
+    }
+    if (!enabled) surf = makeGreyscale(surf, _darkenGreyscale);
+    tex = TextureStats::created(renderer, SDL_CreateTextureFromSurface(renderer, surf));
+    // re-created from _data or _path when needed again
+    TextureStats::setEvictable(tex, [this, enabled]() { (enabled ? _tex : _texBw) = nullptr; });
+    SDL_FreeSurface(surf);
+    if (_quality >= 0) {
+        // TODO: have the default somewhere accessible?
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "");
+    }
+    return tex;
+}
+
+bool Image::isTiled() const
+{
+    return _autoSize.width >= TILED_MIN_SIZE || _autoSize.height >= TILED_MIN_SIZE;
+}
+
+int Image::getLevel(const SDL_Rect& dest) const
+{
+    // smallest level that is still at least as big as the destination,
+    // so the renderer never scales down by more than 2
+    int maxLevel = 0; // last level built by ImageDecoder::makeLevels()
+    while ((_autoSize.width >> maxLevel) > TILE_SIZE || (_autoSize.height >> maxLevel) > TILE_SIZE)
+        maxLevel++;
+    int level = 0;
+    while (level < maxLevel && (_autoSize.width >> (level+1)) >= dest.w && (_autoSize.height >> (level+1)) >= dest.h)
+        level++;
+    if (_level < 0 || level == _level)
+        return level;
+    // hysteresis, so resizing around a level boundary does not switch back and forth:
+    // keep the current level unless it would be scaled down by more than 2.5
+    // or scaled up by more than 10%
+    int w = _autoSize.width >> _level;
+    int h = _autoSize.height >> _level;
+    if (level > _level && (w*2 < dest.w*5 || h*2 < dest.h*5))
+        return _level;
+    if (level < _level && w*10 >= dest.w*9 && h*10 >= dest.h*9)
+        return _level;
+    return level;
+}
+
+bool Image::hasLevel(int level)
+{
+    if (_levelJob && _levelJob->isDone()) {
+        freeLevels((int)_levels.size() - 1);
+        _levels = _levelJob->takeLevels();
+        _levelJob = nullptr;
+        if (_levels.empty())
+            _data.clear(); // decoding failed, don't retry
+    }
+    return level >= 0 && level < (int)_levels.size() && _levels[level];
+}
+
+void Image::loadLevels()
+{
+    // decoding and scaling runs in the background, picked up by hasLevel()
+    if (_levelJob || _data.empty()) return;
+    _levelJob = ImageDecoder::submitLevels(_data, TILE_SIZE);
+}
+
+void Image::freeLevels(int last)
+{
+    for (int i=0; i<=last && i<(int)_levels.size(); i++) {
+        if (_levels[i]) SDL_FreeSurface(_levels[i]);
+        _levels[i] = nullptr;
+    }
+}
+
+bool Image::setLevel(int level)
+{
+    if (!hasLevel(level)) {
+        // current tiles are drawn until the level is ready
+        loadLevels();
+        return false;
+    }
+    freeTiles();
+    _level = level;
+    _tilesEnabled = _enabled;
+    _tilesX = (_levels[level]->w + TILE_SIZE - 1) / TILE_SIZE;
+    _tilesY = (_levels[level]->h + TILE_SIZE - 1) / TILE_SIZE;
+    _tiles.assign((size_t)(_tilesX * _tilesY), nullptr);
+    return true;
+}
+
+void Image::freeTiles()
+{
+    for (auto& tile: _tiles)
+        if (tile) TextureStats::destroy(tile);
+    _tiles.clear();
+}
+
+// copies rect from src with a 1px border of the neighbouring pixels, duplicating
+// the edge of the image, so linear filtering does not show seams between tiles
+static SDL_Surface* copyTile(SDL_Surface* src, const SDL_Rect& rect)
+{
+    SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, rect.w+2, rect.h+2, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!surf) return nullptr;
+    SDL_Rect from = {std::max(0, rect.x-1), std::max(0, rect.y-1), 0, 0};
+    from.w = std::min(src->w, rect.x+rect.w+1) - from.x;
+    from.h = std::min(src->h, rect.y+rect.h+1) - from.y;
+    SDL_Rect to = {from.x - (rect.x-1), from.y - (rect.y-1), from.w, from.h};
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(src, &from, surf, &to);
+    auto px = [surf](int x, int y) -> Uint32& {
+        return *(Uint32*)((Uint8*)surf->pixels + y*surf->pitch + x*4);
+    };
+    int w = surf->w, h = surf->h;
+    if (rect.x == 0)
+        for (int y=0; y<h; y++) px(0, y) = px(1, y);
+    if (rect.x+rect.w == src->w)
+        for (int y=0; y<h; y++) px(w-1, y) = px(w-2, y);
+    if (rect.y == 0)
+        for (int x=0; x<w; x++) px(x, 0) = px(x, 1);
+    if (rect.y+rect.h == src->h)
+        for (int x=0; x<w; x++) px(x, h-1) = px(x, h-2);
+    return surf;
+}
+
+SDL_Texture* Image::getTile(Renderer renderer, int x, int y)
+{
+    SDL_Texture*& tile = _tiles[(size_t)(y * _tilesX + x)];
+    if (tile) return tile;
+    if (!hasLevel(_level)) {
+        // evicted after the level's surface was freed
+        loadLevels();
+        return nullptr;
+    }
+    SDL_Surface* src = _levels[_level];
+    SDL_Rect rect = {x * TILE_SIZE, y * TILE_SIZE, 0, 0};
+    rect.w = std::min(TILE_SIZE, src->w - rect.x);
+    rect.h = std::min(TILE_SIZE, src->h - rect.y);
+    SDL_Surface* surf = copyTile(src, rect);
+    if (!surf) return nullptr;
+    if (!_tilesEnabled) surf = makeGreyscale(surf, _darkenGreyscale);
+    if (_quality >= 0) {
+        char q[] = { (char)('0'+_quality), 0 };
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, q);
+    }
+    tile = TextureStats::created(renderer, SDL_CreateTextureFromSurface(renderer, surf));
+    size_t index = (size_t)(y * _tilesX + x);
+    TextureStats::setEvictable(tile, [this, index]() { _tiles[index] = nullptr; });
+    SDL_FreeSurface(surf);
+    if (_quality >= 0) {
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "");
+    }
+    return tile;
+}
+
+void Image::renderTiled(Renderer renderer, const SDL_Rect& dest)
+{
+    if (dest.w < 1 || dest.h < 1) return;
+    int level = getLevel(dest);
+    if (level != _level || _tilesEnabled != _enabled)
+        setLevel(level);
+    if (_level < 0) return; // not decoded yet
+
+    // only create and draw tiles that are visible
+    SDL_Rect visible;
+    if (SDL_RenderIsClipEnabled(renderer)) {
+        SDL_RenderGetClipRect(renderer, &visible);
+    } else {
+        SDL_RenderGetViewport(renderer, &visible);
+        visible.x = visible.y = 0;
+    }
+    int levelW = std::max(1, _autoSize.width >> _level);
+    int levelH = std::max(1, _autoSize.height >> _level);
+    for (int y=0; y<_tilesY; y++) {
+        // edges are calculated from tile index to avoid gaps from rounding
+        int y0 = dest.y + (int)((int64_t)y * TILE_SIZE * dest.h / levelH);
+        int y1 = dest.y + (int)((int64_t)std::min(levelH, (y+1) * TILE_SIZE) * dest.h / levelH);
+        if (y1 <= visible.y || y0 >= visible.y + visible.h) continue;
+        for (int x=0; x<_tilesX; x++) {
+            int x0 = dest.x + (int)((int64_t)x * TILE_SIZE * dest.w / levelW);
+            int x1 = dest.x + (int)((int64_t)std::min(levelW, (x+1) * TILE_SIZE) * dest.w / levelW);
+            if (x1 <= visible.x || x0 >= visible.x + visible.w) continue;
+            auto tile = getTile(renderer, x, y);
+            if (!tile) continue;
+            // skip the border, see copyTile()
+            SDL_Rect src = {1, 1, std::min(TILE_SIZE, levelW - x*TILE_SIZE), std::min(TILE_SIZE, levelH - y*TILE_SIZE)};
+            SDL_Rect r = {x0, y0, x1-x0, y1-y0};
+            TextureStats::used(tile);
+            SDL_RenderCopy(renderer, tile, &src, &r);
+        }
+    }
+    // the CPU copy is not needed once all tiles are uploaded;
+    // the smaller levels are kept to zoom out without decoding again
+    if (_level < (int)_levels.size() && _levels[_level] &&
+            std::find(_tiles.begin(), _tiles.end(), nullptr) == _tiles.end())
+        freeLevels(_level);
+}
+
 void Image::render(Renderer renderer, int offX, int offY)
 {
     if (_backgroundColor.a > 0) {
@@ -74,26 +330,10 @@ void Image::render(Renderer renderer, int offX, int offY)
         SDL_Rect r = { offX+_pos.left, offY+_pos.top, _size.width, _size.height };
         SDL_RenderFillRect(renderer, &r);
     }
-    if (!_tex && _surf) {
-        if (_quality >= 0) {
-            // set Texture filter/quality when creating the texture
-            char q[] = { (char)('0'+_quality), 0 };
-            if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, q)) {
-                printf("Image: could not set scale quality to %s!\n", q);
-            }
-        }
-        _tex = SDL_CreateTextureFromSurface(renderer, _surf);
-        _surf = makeGreyscale(_surf, _darkenGreyscale);
-        _texBw = SDL_CreateTextureFromSurface(renderer, _surf);
-        SDL_FreeSurface (_surf);
-        if (_quality >= 0) {
-            // TODO: have the default somewhere accessible?
-            SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "");
-        }
-        _surf = nullptr;
-    }
-    auto tex = _enabled ? _tex : _texBw;
-    if (!tex) return;
+    bool tiled = isTiled();
+    auto tex = tiled ? nullptr : getTexture(renderer, _enabled);
+    if (!tex && !tiled) return;
+    if (tex) TextureStats::used(tex);
     if (_fixedAspect) {
         int finalw=0, finalh=0;
         float ar = (float)_autoSize.width / (float)_autoSize.height;
@@ -109,10 +349,16 @@ void Image::render(Renderer renderer, int offX, int offY)
             .w = finalw,
             .h = finalh
         };
-        SDL_RenderCopy(renderer, tex, NULL, &dest);
+        if (tiled)
+            renderTiled(renderer, dest);
+        else
+            SDL_RenderCopy(renderer, tex, NULL, &dest);
     } else {
         SDL_Rect dest = {.x = offX+_pos.left, .y = offY+_pos.top, .w = _size.width, .h = _size.height};
-        SDL_RenderCopy(renderer, tex, NULL, &dest);
+        if (tiled)
+            renderTiled(renderer, dest);
+        else
+            SDL_RenderCopy(renderer, tex, NULL, &dest);
     }
 }
 
@@ -129,10 +375,14 @@ void Image::setDarkenGreyscale(bool value)
 {
     if (_darkenGreyscale == value) return;
     _darkenGreyscale = value;
-    if (_tex)   SDL_DestroyTexture(_tex);
-    if (_texBw) SDL_DestroyTexture(_texBw);
-    _tex = nullptr;
+    // only the greyscale variant depends on this
+    if (_texBw) TextureStats::destroy(_texBw);
     _texBw = nullptr;
+    if (!_tilesEnabled) {
+        freeTiles();
+        _tiles.assign((size_t)(_tilesX * _tilesY), nullptr);
+    }
+    invalidate();
 }
 
 } // namespace
@@ -2,7 +2,9 @@
 #define _UILIB_IMAGE_H
 
 #include "widget.h"
+#include "imagedecoder.h"
 #include <string>
+#include <vector>
 
 namespace Ui {
 
@@ -18,14 +20,48 @@ public:
     // NOTE: this has to be set before the image is rendered for the first time
     virtual void setQuality(int q) { _quality = q; }
     virtual void setDarkenGreyscale(bool value);
+    virtual bool isRenderCacheable() const override { return !_levelJob; }
+
+    // time after which a texture variant that was not drawn gets freed
+    static constexpr uint32_t TEXTURE_KEEP_TIME = 30000; // ms
+    // images this large (width or height) are drawn from tiles of a
+    // downscaled copy that fits the widget size, see renderTiled()
+    static constexpr int TILED_MIN_SIZE = 2048;
+    static constexpr int TILE_SIZE = 512;
+
 protected:
     SDL_Surface *_surf = nullptr;
     SDL_Texture *_tex = nullptr;
     SDL_Texture *_texBw = nullptr;
+    uint32_t _texLastUse = 0;
+    uint32_t _texBwLastUse = 0;
     std::string _path;
+    std::string _data; // encoded image to re-create textures on demand
     bool _fixedAspect=true;
     int _quality=-1;
     bool _darkenGreyscale = true; // makes greyscale version look "disabled"
+
+    // tiled rendering of large images
+    ImageDecoder::JobPtr _levelJob; // decodes _levels in the background
+    std::vector<SDL_Surface*> _levels; // source image scaled down by 2^index, freed once uploaded
+    int _level = -1; // level of _tiles
+    bool _tilesEnabled = true; // tiles are colored (not greyscale)
+    int _tilesX = 0;
+    int _tilesY = 0;
+    std::vector<SDL_Texture*> _tiles; // created when visible
+
+    SDL_Surface* loadSurface();
+    void setAutoSize(int autoW, int autoH, int w, int h);
+    SDL_Texture* getTexture(Renderer renderer, bool enabled);
+    bool isTiled() const;
+    int getLevel(const SDL_Rect& dest) const;
+    bool hasLevel(int level);
+    void loadLevels();
+    void freeLevels(int last);
+    bool setLevel(int level);
+    void freeTiles();
+    SDL_Texture* getTile(Renderer renderer, int x, int y);
+    void renderTiled(Renderer renderer, const SDL_Rect& dest);
 };
 
 } // namespace Ui
@@ -0,0 +1,221 @@
+#include "imagecache.h"
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <utime.h>
+#include "../core/fileutil.h"
+
+
+namespace Ui {
+
+namespace {
+
+struct Header {
+    char magic[4];
+    uint32_t version; // ImageCache::VERSION, also catches endianness mismatch
+    uint64_t key;
+    uint64_t dataSize; // size of the encoded image, to detect hash collisions
+    uint32_t width;
+    uint32_t height;
+};
+
+struct Entry {
+    size_t size;
+    time_t lastUse;
+};
+
+std::mutex mutex;
+std::string dir;
+size_t maxSize = 0;
+size_t totalSize = 0;
+std::map<std::string, Entry> entries;
+std::set<std::string> writing; // entries that are currently being written
+
+std::string keyToName(uint64_t key)
+{
+    char buf[21];
+    snprintf(buf, sizeof(buf), "%016llx.bin", (unsigned long long)key);
+    return buf;
+}
+
+void evict()
+{
+    // has to be called with mutex held
+    if (totalSize <= maxSize) return;
+    std::vector<std::pair<time_t, std::string>> order;
+    order.reserve(entries.size());
+    for (const auto& pair: entries)
+        order.push_back({pair.second.lastUse, pair.first});
+    std::sort(order.begin(), order.end());
+    // free up some room so we don't evict on every store
+    size_t target = maxSize / 4 * 3;
+    for (const auto& pair: order) {
+        if (totalSize <= target) break;
+        unlink(os_pathcat(dir, pair.second).c_str());
+        totalSize -= entries[pair.second].size;
+        entries.erase(pair.second);
+    }
+}
+
+} // namespace
+
+
+void ImageCache::setDir(const std::string& newDir, size_t newMaxSize)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    dir = newDir;
+    maxSize = newMaxSize;
+    totalSize = 0;
+    entries.clear();
+    writing.clear();
+    if (dir.empty() || !maxSize) {
+        maxSize = 0;
+        return;
+    }
+    mkdir_recursive(dir);
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        fprintf(stderr, "ImageCache: could not open %s: %s\n", dir.c_str(), strerror(errno));
+        maxSize = 0;
+        return;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        std::string name = ent->d_name;
+        if (name.length() == 24 && name.compare(16, 8, ".bin.tmp") == 0) {
+            // left over from a crash
+            unlink(os_pathcat(dir, name).c_str());
+            continue;
+        }
+        if (name.length() != 20 || name.compare(16, 4, ".bin") != 0) continue;
+        struct stat st;
+        if (stat(os_pathcat(dir, name).c_str(), &st) != 0) continue;
+        entries[name] = { (size_t)st.st_size, st.st_mtime };
+        totalSize += (size_t)st.st_size;
+    }
+    closedir(d);
+    printf("ImageCache: %u entries, %u KiB\n", (unsigned)entries.size(), (unsigned)(totalSize/1024));
+    evict();
+}
+
+bool ImageCache::isEnabled()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxSize > 0;
+}
+
+uint64_t ImageCache::makeKey(const std::string& data, const std::list<ImageFilter>& filters)
+{
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto add = [&h](const std::string& s) {
+        for (unsigned char c: s) {
+            h ^= c;
+            h *= 0x100000001b3ull;
+        }
+        h ^= 0xff; // separator
+        h *= 0x100000001b3ull;
+    };
+    add(data);
+    for (const auto& filter: filters) {
+        add(filter.name);
+        add(filter.arg);
+    }
+    return h;
+}
+
+SDL_Surface* ImageCache::load(uint64_t key, size_t dataSize)
+{
+    std::string path;
+    std::string name = keyToName(key);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!maxSize) return nullptr;
+        auto it = entries.find(name);
+        if (it == entries.end()) return nullptr;
+        it->second.lastUse = time(nullptr);
+        path = os_pathcat(dir, name);
+    }
+    utime(path.c_str(), nullptr); // keep track of last use across runs
+
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return nullptr;
+    Header hdr;
+    SDL_Surface* surf = nullptr;
+    if (fread(&hdr, 1, sizeof(hdr), f) == sizeof(hdr) && memcmp(hdr.magic, "PTIC", 4) == 0 &&
+            hdr.version == VERSION && hdr.key == key && hdr.dataSize == dataSize &&
+            hdr.width > 0 && hdr.height > 0 && hdr.width < 0x8000 && hdr.height < 0x8000) {
+        surf = SDL_CreateRGBSurfaceWithFormat(0, (int)hdr.width, (int)hdr.height, 32, SDL_PIXELFORMAT_ARGB8888);
+    }
+    if (surf) {
+        // pitch is width*4 for 32bit surfaces, so this is a single read
+        size_t len = (size_t)surf->pitch * (size_t)surf->h;
+        if (fread(surf->pixels, 1, len, f) != len) {
+            SDL_FreeSurface(surf);
+            surf = nullptr;
+        }
+    }
+    fclose(f);
+    if (!surf) {
+        // outdated or broken, drop it so it gets written again
+        fprintf(stderr, "ImageCache: invalid entry %s\n", name.c_str());
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(name);
+        if (it != entries.end()) {
+            unlink(path.c_str());
+            totalSize -= it->second.size;
+            entries.erase(it);
+        }
+    }
+    return surf;
+}
+
+void ImageCache::store(uint64_t key, size_t dataSize, SDL_Surface* surf)
+{
+    std::string name = keyToName(key);
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!maxSize || entries.find(name) != entries.end()) return;
+        if (!writing.insert(name).second) return;
+        path = os_pathcat(dir, name);
+    }
+
+    // this also turns a color key into alpha
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!argb) {
+        std::lock_guard<std::mutex> lock(mutex);
+        writing.erase(name);
+        return;
+    }
+    Header hdr = { {'P','T','I','C'}, VERSION, key, dataSize, (uint32_t)argb->w, (uint32_t)argb->h };
+    // write to a temporary file first, so there are no partial entries
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    bool ok = f != nullptr;
+    if (ok) ok = fwrite(&hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+    for (int y=0; ok && y<argb->h; y++) {
+        const char* row = (const char*)argb->pixels + y * argb->pitch;
+        ok = fwrite(row, 4, (size_t)argb->w, f) == (size_t)argb->w;
+    }
+    if (f && fclose(f) != 0) ok = false;
+    size_t size = sizeof(hdr) + (size_t)argb->w * (size_t)argb->h * 4;
+    SDL_FreeSurface(argb);
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "ImageCache: could not write %s\n", path.c_str());
+        unlink(tmp.c_str());
+        ok = false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    writing.erase(name);
+    if (!ok || dir.empty() || !maxSize) return;
+    entries[name] = { size, time(nullptr) };
+    totalSize += size;
+    evict();
+}
+
+} // namespace Ui
@@ -0,0 +1,37 @@
+#ifndef _UILIB_IMAGECACHE_H
+#define _UILIB_IMAGECACHE_H
+
+
+#include <string>
+#include <list>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "imagefilter.h"
+
+
+namespace Ui {
+
+// Optional on-disk cache of decoded and filtered images as raw ARGB8888.
+// Entries are keyed by a hash of the encoded image and the filter chain, so
+// changed pack files or filters simply result in a different entry. Least
+// recently used entries get deleted when the cache grows over its size limit.
+// All methods are thread safe.
+class ImageCache final
+{
+public:
+    // bump this if decoding or filters change the resulting pixels
+    static constexpr uint32_t VERSION = 1;
+
+    // enables the cache, maxSize is in bytes; 0 disables it
+    static void setDir(const std::string& dir, size_t maxSize);
+    static bool isEnabled();
+
+    static uint64_t makeKey(const std::string& data, const std::list<ImageFilter>& filters);
+    // returns a new surface or nullptr if not cached
+    static SDL_Surface* load(uint64_t key, size_t dataSize);
+    static void store(uint64_t key, size_t dataSize, SDL_Surface* surf);
+};
+
+} // namespace Ui
+
+#endif // _UILIB_IMAGECACHE_H
@@ -0,0 +1,314 @@
+#include "imagedecoder.h"
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_image.h>
+#include "colorhelper.h"
+#include "imagecache.h"
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#endif
+#include <algorithm>
+
+#define SDL_HAS_SOFT_STRETCH_LINEAR SDL_VERSION_ATLEAST(2, 0, 16)
+
+namespace Ui {
+
+#ifndef __EMSCRIPTEN__
+namespace {
+
+class Pool final {
+public:
+    ~Pool()
+    {
+        // ImageDecoder::shutdown() should have been called by Ui already
+        stopWorkers();
+    }
+
+    // returns false if no workers were running
+    bool stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        queueCond.notify_all();
+        for (auto& worker: workers) worker.join();
+        bool res = !workers.empty();
+        workers.clear();
+        queue.clear();
+        return res;
+    }
+
+    void push(const ImageDecoder::JobPtr& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (workers.empty()) start();
+            queue.push_back(job);
+        }
+        queueCond.notify_one();
+    }
+
+    std::mutex mutex;
+    std::condition_variable queueCond;
+    std::condition_variable doneCond;
+
+private:
+    void start()
+    {
+        // leave one core for the main thread
+        unsigned n = std::thread::hardware_concurrency();
+        n = (n > 2) ? (n - 1) : 1;
+        if (n > 8) n = 8;
+        // NOTE: SDL_image initializes decoders lazily, which is not thread safe
+        IMG_Init(IMG_INIT_PNG);
+        stop = false;
+        for (unsigned i=0; i<n; i++)
+            workers.emplace_back(&Pool::work, this);
+    }
+
+    void work();
+
+    std::deque<ImageDecoder::JobPtr> queue;
+    std::vector<std::thread> workers;
+    bool stop = false;
+};
+
+Pool pool;
+
+} // namespace
+#endif
+
+
+ImageDecoder::Job::~Job()
+{
+    if (_surf) SDL_FreeSurface(_surf);
+    for (auto level: _levels) SDL_FreeSurface(level);
+}
+
+ImageDecoder::JobPtr ImageDecoder::submit(std::string data, std::list<ImageFilter> filters)
+{
+    return start(std::make_shared<Job>(std::move(data), std::move(filters)));
+}
+
+ImageDecoder::JobPtr ImageDecoder::submitLevels(std::string data, int minSize)
+{
+    auto job = std::make_shared<Job>(std::move(data), std::list<ImageFilter>{});
+    job->_levelSize = minSize;
+    return start(job);
+}
+
+#ifdef __EMSCRIPTEN__
+bool ImageDecoder::Job::isDone() const
+{
+    return _done;
+}
+
+void ImageDecoder::Job::run()
+{
+}
+
+SDL_Surface* ImageDecoder::Job::take(bool)
+{
+    auto surf = _surf;
+    _surf = nullptr;
+    return surf;
+}
+
+std::vector<SDL_Surface*> ImageDecoder::Job::takeLevels(bool)
+{
+    std::vector<SDL_Surface*> levels;
+    levels.swap(_levels);
+    return levels;
+}
+
+ImageDecoder::JobPtr ImageDecoder::start(JobPtr job)
+{
+    // no threads: decode right away
+    job->_surf = decode(job->_data, job->_filters);
+    if (job->_levelSize > 0) {
+        job->_levels = makeLevels(job->_surf, job->_levelSize);
+        job->_surf = nullptr;
+    }
+    job->_done = true;
+    return job;
+}
+#else
+bool ImageDecoder::Job::isDone() const
+{
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return _done;
+}
+
+void ImageDecoder::Job::run()
+{
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    if (_done || _data.empty())
+        return; // already done or running on a different thread
+    std::string data = std::move(_data);
+    _data.clear();
+    lock.unlock();
+    auto surf = decode(data, _filters);
+    std::vector<SDL_Surface*> levels;
+    if (_levelSize > 0) {
+        levels = makeLevels(surf, _levelSize);
+        surf = nullptr;
+    }
+    lock.lock();
+    _surf = surf;
+    _levels = std::move(levels);
+    _done = true;
+    pool.doneCond.notify_all();
+}
+
+SDL_Surface* ImageDecoder::Job::take(bool wait)
+{
+    if (wait) {
+        // if the job is still queued, run it on the calling thread
+        run();
+    }
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    if (!_done && !wait)
+        return nullptr;
+    pool.doneCond.wait(lock, [this]() { return _done; });
+    auto surf = _surf;
+    _surf = nullptr;
+    return surf;
+}
+
+std::vector<SDL_Surface*> ImageDecoder::Job::takeLevels(bool wait)
+{
+    std::vector<SDL_Surface*> levels;
+    if (wait) run();
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    if (!_done && !wait)
+        return levels;
+    pool.doneCond.wait(lock, [this]() { return _done; });
+    levels.swap(_levels);
+    return levels;
+}
+
+void Pool::work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queueCond.wait(lock, [this]() { return stop || !queue.empty(); });
+        if (stop) break;
+        auto job = std::move(queue.front());
+        queue.pop_front();
+        if (job.use_count() == 1)
+            continue; // dropped by its owner
+        lock.unlock();
+        job->run();
+        job.reset();
+        lock.lock();
+    }
+}
+
+ImageDecoder::JobPtr ImageDecoder::start(JobPtr job)
+{
+    if (job->_data.empty()) {
+        job->_done = true;
+        return job;
+    }
+    pool.push(job);
+    return job;
+}
+#endif
+
+void ImageDecoder::shutdown()
+{
+#ifndef __EMSCRIPTEN__
+    // queued jobs are dropped, their owners decode them on the calling thread when taken
+    if (pool.stopWorkers()) IMG_Quit();
+#endif
+}
+
+bool ImageDecoder::getSize(const std::string& data, int& w, int& h)
+{
+    // the first chunk of a PNG has to be IHDR, which starts with big endian width and height
+    const auto* p = (const unsigned char*)data.c_str();
+    if (data.length() < 24 || memcmp(p, "\x89PNG\r\n\x1a\n", 8) != 0 || memcmp(p+12, "IHDR", 4) != 0)
+        return false;
+    w = (int)((uint32_t)p[16]<<24 | (uint32_t)p[17]<<16 | (uint32_t)p[18]<<8 | p[19]);
+    h = (int)((uint32_t)p[20]<<24 | (uint32_t)p[21]<<16 | (uint32_t)p[22]<<8 | p[23]);
+    return w > 0 && h > 0;
+}
+
+SDL_Surface* ImageDecoder::decode(const std::string& data, const std::list<ImageFilter>& filters)
+{
+    if (data.empty()) return nullptr;
+    uint64_t key = 0;
+    if (ImageCache::isEnabled()) {
+        key = ImageCache::makeKey(data, filters);
+        auto surf = ImageCache::load(key, data.length());
+        if (surf) return surf;
+    }
+    // NOTE: if the app hangs or crashes in IMG_Load, you are probably mixing incompatible DLLs
+    auto surf = IMG_Load_RW(SDL_RWFromConstMem(data.c_str(), (int)data.length()), 1);
+    if (!surf) {
+        fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
+        return nullptr;
+    }
+    surf = process(surf, filters);
+    if (surf && key) ImageCache::store(key, data.length(), surf);
+    return surf;
+}
+
+SDL_Surface* ImageDecoder::process(SDL_Surface* surf, const std::list<ImageFilter>& filters)
+{
+    if (!surf) return nullptr;
+    // if any corner pixel is #ff00ff, make that color transparent
+    surf = makeTransparent(surf, 0xff, 0x00, 0xff, filters.empty());
+    // if filters have an overlay, we need an RGB(A) surface
+    bool needsRGB = false;
+    for (auto& filter: filters) {
+        if (filter.name == "overlay") {
+            needsRGB = true;
+            break;
+        }
+    }
+    if (needsRGB && surf->format->BitsPerPixel < 32) {
+        auto old = surf;
+        surf = SDL_ConvertSurfaceFormat(old, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(old);
+        if (!surf) return nullptr;
+    }
+    // apply filters
+    for (const auto& filter: filters)
+        surf = filter.apply(surf);
+    return surf;
+}
+
+std::vector<SDL_Surface*> ImageDecoder::makeLevels(SDL_Surface* surf, int minSize)
+{
+    std::vector<SDL_Surface*> levels;
+    if (!surf) return levels;
+    SDL_Surface* level = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(surf);
+    while (level) {
+        levels.push_back(level);
+        if (level->w <= minSize && level->h <= minSize) return levels;
+        // halve the size for each level, linear filtering averages 2x2 pixels
+        SDL_Surface* half = SDL_CreateRGBSurfaceWithFormat(0, std::max(1, level->w/2), std::max(1, level->h/2),
+                32, SDL_PIXELFORMAT_ARGB8888);
+        if (half) {
+#if SDL_HAS_SOFT_STRETCH_LINEAR
+            if (SDL_SoftStretchLinear(level, nullptr, half, nullptr) != 0)
+#endif
+            {
+                SDL_SetSurfaceBlendMode(level, SDL_BLENDMODE_NONE);
+                SDL_BlitScaled(level, nullptr, half, nullptr);
+            }
+        }
+        level = half;
+    }
+    fprintf(stderr, "ImageDecoder: could not scale image: %s\n", SDL_GetError());
+    return levels;
+}
+
+} // namespace Ui
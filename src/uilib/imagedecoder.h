@@ -0,0 +1,66 @@
+#ifndef _UILIB_IMAGEDECODER_H
+#define _UILIB_IMAGEDECODER_H
+
+
+#include <string>
+#include <list>
+#include <memory>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "imagefilter.h"
+
+
+namespace Ui {
+
+// Decodes images and applies the filter chain on a pool of worker threads.
+// Only the resulting SDL_Surface is handed back, texture upload has to happen
+// on the render thread. On targets without threads, jobs run on submit.
+class ImageDecoder final
+{
+public:
+    class Job final {
+        friend class ImageDecoder;
+    public:
+        Job(std::string&& data, std::list<ImageFilter>&& filters)
+            : _data(std::move(data)), _filters(std::move(filters)) {}
+        ~Job();
+        bool isDone() const;
+        // decodes on the calling thread, unless a worker already picked it up
+        void run();
+        // returns the decoded surface and transfers ownership to the caller;
+        // if wait is false and the job is not done yet, this returns nullptr
+        SDL_Surface* take(bool wait=true);
+        // same as take() for jobs started with submitLevels()
+        std::vector<SDL_Surface*> takeLevels(bool wait=true);
+    protected:
+        std::string _data;
+        std::list<ImageFilter> _filters;
+        int _levelSize = 0; // build levels down to this size if > 0
+        SDL_Surface* _surf = nullptr;
+        std::vector<SDL_Surface*> _levels;
+        bool _done = false;
+    };
+    using JobPtr = std::shared_ptr<Job>;
+
+    static JobPtr submit(std::string data, std::list<ImageFilter> filters={});
+    // decodes to ARGB8888 and builds a chain of copies, each half the size of
+    // the previous one, until width and height are <= minSize
+    static JobPtr submitLevels(std::string data, int minSize);
+
+    // synchronous versions of what a job does
+    static SDL_Surface* decode(const std::string& data, const std::list<ImageFilter>& filters={});
+    static SDL_Surface* process(SDL_Surface* surf, const std::list<ImageFilter>& filters={});
+    static std::vector<SDL_Surface*> makeLevels(SDL_Surface* surf, int minSize);
+    // reads width and height from a PNG header without decoding
+    static bool getSize(const std::string& data, int& w, int& h);
+
+    // stops the worker threads, has to be called before shutting down SDL
+    static void shutdown();
+
+private:
+    static JobPtr start(JobPtr job);
+};
+
+} // namespace Ui
+
+#endif // _UILIB_IMAGEDECODER_H
@@ -1,10 +1,50 @@
 #include "imagefilter.h"
 #include "colorhelper.h"
+#include "imagecache.h"
 #include <stdio.h>
+#include <map>
+#include <mutex>
 
 namespace Ui {
 
-SDL_Surface* ImageFilter::apply(SDL_Surface *surf)
+// decoded overlays by ImageCache::makeKey(data)
+static std::map<uint64_t, std::shared_ptr<ImageFilter::Overlay>> overlayCache;
+static std::mutex overlayCacheMutex;
+
+static std::shared_ptr<ImageFilter::Overlay> getOverlay(const std::string& data)
+{
+    uint64_t key = ImageCache::makeKey(data, {});
+    {
+        std::lock_guard<std::mutex> lock(overlayCacheMutex);
+        auto it = overlayCache.find(key);
+        if (it != overlayCache.end())
+            return it->second;
+    }
+    // decode without holding the lock, if another thread was faster, its result is used
+    auto surf = IMG_Load_RW(SDL_RWFromConstMem(data.c_str(), (int)data.length()), 1);
+    if (surf)
+        surf = makeTransparent(surf, 0xff, 0x00, 0xff, false);
+    else
+        fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
+    auto overlay = std::make_shared<ImageFilter::Overlay>(surf); // failures are cached as well
+    std::lock_guard<std::mutex> lock(overlayCacheMutex);
+    return overlayCache.emplace(key, overlay).first->second;
+}
+
+void ImageFilter::clearCache()
+{
+    // filters that still use an overlay keep it alive
+    std::lock_guard<std::mutex> lock(overlayCacheMutex);
+    overlayCache.clear();
+}
+
+void ImageFilter::prepare()
+{
+    if (name=="overlay" && !arg.empty() && !overlay)
+        overlay = getOverlay(arg);
+}
+
+SDL_Surface* ImageFilter::apply(SDL_Surface *surf) const
 {
     if (!surf) return surf;
     
@@ -12,15 +52,11 @@ SDL_Surface* ImageFilter::apply(SDL_Surface *surf)
         return makeGreyscale(surf, true);
     }
     if (name=="overlay" && !arg.empty()) {
-        auto overlay = IMG_Load_RW(SDL_RWFromMem((void*)arg.c_str(), (int)arg.length()), 1);
-        overlay = makeTransparent(overlay, 0xff, 0x00, 0xff, false);
-        if (overlay) {
-            SDL_BlitSurface(overlay, nullptr, surf, nullptr);
-            SDL_FreeSurface(overlay);
+        auto o = overlay ? overlay : getOverlay(arg); // prepare() was not called
+        if (o->surf) {
+            std::lock_guard<std::mutex> lock(o->mutex);
+            SDL_BlitSurface(o->surf, nullptr, surf, nullptr);
         }
-        else {
-            fprintf(stderr, "IMG_Load: %s\n", IMG_GetError());
-        }        
     }
     
     return surf;
@@ -4,19 +4,36 @@
 
 #include "colorhelper.h"
 #include <string>
+#include <memory>
+#include <mutex>
 #include <SDL2/SDL_image.h>
 
 
 namespace Ui {
 
 struct ImageFilter {
+    // decoded overlay image, shared by all filters with the same arg
+    struct Overlay final {
+        Overlay(SDL_Surface* surf) : surf(surf) {}
+        ~Overlay() { if (surf) SDL_FreeSurface(surf); }
+        SDL_Surface* const surf;
+        std::mutex mutex; // blitting modifies the source's blit map
+    };
+
     ImageFilter(std::string name) { this->name=name; }
     ImageFilter(std::string name, std::string arg) { this->name=name; this->arg=arg; }
     
     std::string name;
     std::string arg;
+    std::shared_ptr<Overlay> overlay; // set by prepare()
     
-    SDL_Surface* apply(SDL_Surface *surf);
+    // decodes what apply() needs up front, so filters that run on decoder
+    // threads only do the actual filtering
+    void prepare();
+    SDL_Surface* apply(SDL_Surface *surf) const;
+
+    // decoded overlay images are kept until this is called, i.e. when unloading a pack
+    static void clearCache();
 
     bool operator==(const ImageFilter& rhs) const
     {
@@ -1,6 +1,8 @@
 #include "label.h"
 #include <string.h>
 #include "textutil.h"
+#include "glyphatlas.h"
+#include "texturestats.h"
 
 
 namespace Ui {
@@ -15,7 +17,7 @@ Label::Label(int x, int y, int w, int h, FONT font, const std::string& text)
 }
 Label::~Label()
 {
-    if (_tex) SDL_DestroyTexture(_tex);
+    if (_tex) TextureStats::destroy(_tex);
     _tex = nullptr;
 }
 
@@ -28,17 +30,29 @@ void Label::render(Renderer renderer, int offX, int offY)
         SDL_RenderFillRect(renderer, &r);
     }
     if (!_tex && !_text.empty() && _font) {
-        SDL_Color color = {_textColor.r, _textColor.g, _textColor.b};
-        SDL_Surface* surf = RenderText(_font, _text.c_str(), color, _halign);
-        if (surf) {
-            _tex = SDL_CreateTextureFromSurface(renderer, surf);
-            _autoSize = {surf->w, surf->h};
-            SDL_FreeSurface(surf);
-        } else {
-            printf("Text render error: %s\n", TTF_GetError());
+        if (!_glyphsValid || _atlasRenderer != renderer || _atlasGeneration != GlyphAtlas::getGeneration()) {
+            // decided once per text, font and renderer
+            _atlas = GlyphAtlas::canRender(_text) ? GlyphAtlas::get(renderer, _font) : nullptr;
+            _atlasRenderer = renderer;
+            _atlasGeneration = GlyphAtlas::getGeneration();
+            if (_atlas) _autoSize = _atlas->layout(_text, _halign, _glyphs);
+            _glyphsValid = true;
+        }
+        if (!_atlas) {
+            SDL_Color color = {_textColor.r, _textColor.g, _textColor.b};
+            SDL_Surface* surf = RenderText(_font, _text.c_str(), color, _halign);
+            if (surf) {
+                _tex = TextureStats::created(renderer, SDL_CreateTextureFromSurface(renderer, surf));
+                TextureStats::setEvictable(_tex, [this]() { _tex = nullptr; });
+                _autoSize = {surf->w, surf->h};
+                SDL_FreeSurface(surf);
+            } else {
+                printf("Text render error: %s\n", TTF_GetError());
+            }
         }
     }
-    if (!_tex) return;
+    GlyphAtlas* atlas = (_glyphsValid && !_text.empty() && _font) ? _atlas : nullptr;
+    if (!_tex && !atlas) return;
     // TODO: gravity
     int x = offX + _pos.left;
     int mx = x + _size.width/2;
@@ -83,7 +97,12 @@ void Label::render(Renderer renderer, int offX, int offY)
         src.w = _size.width;
         psrc = &src;
     }
-    SDL_RenderCopy(renderer, _tex, psrc, &dest);
+    if (_tex) {
+        TextureStats::used(_tex);
+        SDL_RenderCopy(renderer, _tex, psrc, &dest);
+    }
+    else // text starts at dest, clipped to dest if it is too big
+        atlas->draw(_glyphs, dest.x, dest.y, _textColor, psrc ? &dest : nullptr);
 }
 
 void Label::setText(const std::string& text)
@@ -94,16 +113,48 @@ void Label::setText(const std::string& text)
     if (_font && !_text.empty()) SizeText(_font, _text.c_str(), &autoW, &autoH);
     _autoSize = { autoW, autoH };
     _minSize = _autoSize; // until we support stretching or ellipsis
-    if (_tex) SDL_DestroyTexture(_tex);
+    if (_tex) TextureStats::destroy(_tex);
+    _tex = nullptr;
+    _glyphsValid = false;
+    _atlas = nullptr;
+    invalidate();
+}
+
+void Label::setFont(FONT font)
+{
+    if (font == _font) return;
+    _font = font;
+    int autoW=0, autoH=0;
+    if (_font && !_text.empty()) SizeText(_font, _text.c_str(), &autoW, &autoH);
+    _autoSize = { autoW, autoH };
+    _minSize = _autoSize; // until we support stretching or ellipsis
+    if (_tex) TextureStats::destroy(_tex);
     _tex = nullptr;
+    _glyphsValid = false;
+    _atlas = nullptr;
+    invalidate();
 }
 
 void Label::setTextColor(Widget::Color c)
 {
     if (_textColor == c) return;
     _textColor = c;
-    if (_tex) SDL_DestroyTexture(_tex);
+    // glyphs are colored when drawing, so only the texture needs an update
+    if (_tex) TextureStats::destroy(_tex);
     _tex = nullptr;
+    invalidate();
+}
+
+void Label::setTextAlignment(HAlign halign, VAlign valign)
+{
+    if (_halign != halign) {
+        if (_tex) TextureStats::destroy(_tex);
+        _tex = nullptr;
+        _glyphsValid = false;
+    }
+    _halign = halign;
+    _valign = valign;
+    invalidate();
 }
 
 
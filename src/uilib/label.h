@@ -3,10 +3,14 @@
 
 #include <SDL2/SDL_ttf.h>
 #include <string>
+#include <vector>
 #include "widget.h"
 
 namespace Ui {
 
+struct GlyphQuad;
+class GlyphAtlas;
+
 class Label : public Widget
 {
 public:
@@ -29,15 +33,22 @@ public:
 protected:
     FONT _font;
     std::string _text;
-    SDL_Texture *_tex = nullptr;
+    SDL_Texture *_tex = nullptr; // only used if text can not be drawn from GlyphAtlas
+    std::vector<GlyphQuad> _glyphs;
+    bool _glyphsValid = false; // _atlas and _glyphs are up to date
+    GlyphAtlas* _atlas = nullptr; // null if text can not be drawn from GlyphAtlas
+    Renderer _atlasRenderer = nullptr;
+    unsigned _atlasGeneration = 0;
     Widget::Color _textColor = {255,255,255};
     HAlign _halign = HAlign::CENTER;
     VAlign _valign = VAlign::MIDDLE;
     
 public:
     virtual void setText(const std::string& text);
-    virtual void setTextAlignment(HAlign halign, VAlign valign) { _halign = halign; _valign = valign; }
+    virtual void setFont(FONT font);
+    virtual void setTextAlignment(HAlign halign, VAlign valign);
     virtual void setTextColor(Widget::Color c);
+    virtual bool isRenderCacheable() const override { return true; }
     const std::string& getText() const { return _text; }
     const Widget::Color getTextColor() const { return _textColor; }
     
@@ -0,0 +1,234 @@
+#ifndef _UILIB_SCROLLLIST_H
+#define _UILIB_SCROLLLIST_H
+
+#include "container.h"
+#include <functional>
+#include <vector>
+
+namespace Ui {
+
+// Vertical list of rows with fixed height. Only rows in the visible range
+// (plus some overscan) have a widget. Widgets are created by createRow and
+// get reused for other rows when scrolling, bindRow assigns a row to a widget.
+class ScrollList : public Container {
+public:
+    typedef std::function<Widget*(void)> create_callback;
+    typedef std::function<void(Widget*, size_t)> bind_callback;
+
+    static constexpr size_t OVERSCAN = 2; // rows before and after visible range
+
+    ScrollList(int x, int y, int w, int h, create_callback createRow, bind_callback bindRow)
+        : Container(x,y,w,h), _createRow(createRow), _bindRow(bindRow)
+    {
+        onScroll += {this, [this](void*, int x, int y, unsigned mod) {
+            scrollBy(x, y);
+        }};
+    }
+
+    virtual void setRowCount(size_t count)
+    {
+        _rowCount = count;
+        // rebind all widgets
+        for (auto& row: _rowIndex) row = NO_ROW;
+        relayout();
+    }
+
+    size_t getRowCount() const { return _rowCount; }
+
+    // returns the row bound to w or NO_ROW
+    size_t getRow(const Widget* w) const
+    {
+        for (size_t i=0; i<_children.size(); i++)
+            if (_children[i] == w) return _rowIndex[i];
+        return NO_ROW;
+    }
+
+    // re-run bindRow for widgets of the visible rows
+    void refresh()
+    {
+        for (size_t i=0; i<_children.size(); i++)
+            if (_rowIndex[i] != NO_ROW) _bindRow(_children[i], _rowIndex[i]);
+    }
+
+    virtual void setRowHeight(int h) { _rowHeight = h; relayout(); }
+    virtual void setPadding(int padding) { _padding = padding; relayout(); }
+    virtual void setSpacing(int spacing) { _spacing = spacing; relayout(); }
+
+    virtual void setSize(Size size) override
+    {
+        if (size.width < _minSize.width) size.width = _minSize.width;
+        if (size.height < _minSize.height) size.height = _minSize.height;
+        Container::setSize(size);
+        invalidateLayout();
+    }
+
+    virtual void clearChildren() override
+    {
+        Container::clearChildren();
+        _rowIndex.clear();
+    }
+
+    virtual void scrollBy(int x, int y)
+    {
+        (void)x; // unused
+        if (y==0) return;
+        scrollTo(0, _scrollY + y);
+    }
+
+    virtual void scrollTo(int x, int y)
+    {
+        (void)x; // unused
+        if (y < _scrollMaxY) y = _scrollMaxY;
+        if (y > 0) y = 0;
+        if (y == _scrollY) return;
+        _scrollY = y;
+        relayout();
+    }
+
+    int getScrollY() const
+    {
+        return _scrollY;
+    }
+
+    void relayout()
+    {
+        beginLayoutPass();
+        int pitch = _rowHeight + _spacing;
+        int contentHeight = 2*_padding + (_rowCount ? (int)_rowCount*pitch - _spacing : 0);
+        _scrollMaxY = _size.height - contentHeight;
+        if (_scrollMaxY > 0) _scrollMaxY = 0;
+        if (_scrollY < _scrollMaxY) _scrollY = _scrollMaxY;
+        if (_scrollY > 0) _scrollY = 0;
+
+        // visible range + overscan
+        size_t first = 0, last = 0;
+        if (_rowCount && pitch > 0) {
+            int top = -_scrollY - _padding;
+            first = top > 0 ? (size_t)(top / pitch) : 0;
+            last = (size_t)((top + _size.height) / pitch) + 1;
+            first = first > OVERSCAN ? first - OVERSCAN : 0;
+            last = std::min(last + OVERSCAN, _rowCount);
+            if (first > last) first = last;
+        }
+
+        // keep widgets that are still in range, put the others into the pool
+        std::vector<bool> bound(last - first, false);
+        std::vector<size_t> pool;
+        for (size_t i=0; i<_children.size(); i++) {
+            size_t row = _rowIndex[i];
+            if (row != NO_ROW && row >= first && row < last && !bound[row - first])
+                bound[row - first] = true;
+            else
+                pool.push_back(i);
+        }
+        for (size_t row=first; row<last; row++) {
+            if (bound[row - first]) continue;
+            size_t i;
+            if (!pool.empty()) {
+                i = pool.back();
+                pool.pop_back();
+            } else {
+                Widget* w = _createRow();
+                if (!w) break;
+                Container::addChild(w);
+                _rowIndex.push_back(NO_ROW);
+                i = _children.size() - 1;
+                if (w->getMinWidth() + 2*_padding > _minSize.width)
+                    _minSize.width = w->getMinWidth() + 2*_padding;
+            }
+            _rowIndex[i] = row;
+            _bindRow(_children[i], row);
+        }
+        for (size_t i: pool) {
+            if (_children[i] == _hoverChild) {
+                _hoverChild->onMouseLeave.emit(_hoverChild);
+                _hoverChild = nullptr;
+            }
+            _rowIndex[i] = NO_ROW;
+            _children[i]->setVisible(false);
+        }
+
+        for (size_t i=0; i<_children.size(); i++) {
+            if (_rowIndex[i] == NO_ROW) continue;
+            auto w = _children[i];
+            int y = _padding + _scrollY + (int)_rowIndex[i]*pitch;
+            w->setPosition({_padding, y});
+            w->setSize({_size.width - 2*_padding, _rowHeight});
+            // overscan rows stay bound, but are not rendered or hit outside of our area
+            bool visible = y + _rowHeight > 0 && y < _size.height;
+            if (!visible && w == _hoverChild) {
+                _hoverChild->onMouseLeave.emit(_hoverChild);
+                _hoverChild = nullptr;
+            }
+            w->setVisible(visible);
+        }
+
+        _minSize.height = 2*_padding;
+        _maxSize = {-1,-1};
+        _autoSize = {_minSize.width, contentHeight};
+    }
+
+    virtual bool isHit(int x, int y) const override
+    {
+        // the whole area scrolls, not only rows
+        return Widget::isHit(x, y);
+    }
+
+    virtual const Widget* getHit(int x, int y) const override
+    {
+        for (const auto& w: _children) {
+            if (w->getVisible() && w->getHit(x - w->getLeft(), y - w->getTop())) return w;
+        }
+        if (Widget::isHit(x + _pos.left, y + _pos.top)) return this;
+        return nullptr;
+    }
+
+    virtual void render(Renderer renderer, int offX, int offY) override
+    {
+        // children, clipped to our area so scrolled out parts are not rendered
+        SDL_Rect clip = { offX+_pos.left, offY+_pos.top, _size.width, _size.height };
+        if (pushClipRect(renderer, clip)) {
+            Container::render(renderer, offX, offY);
+            popClipRect(renderer);
+        }
+        // scroll bar/position
+        if (_scrollMaxY < 0 && _size.height > 0) {
+            int x = _pos.left + _size.width - 3;
+            int y = _pos.top;
+            int w = 2;
+            int h = _size.height;
+            int barh = (h * _size.height) / (_size.height - _scrollMaxY);
+            if (barh >= h) barh = h-1;
+            if (barh < 2) barh = 2;
+            int bary = y + (h - barh)*_scrollY/_scrollMaxY;
+            SDL_SetRenderDrawColor(renderer, 0x0, 0x0, 0x0, 0x80);
+            SDL_Rect r1 = { offX+x, offY+y, w, h };
+            SDL_RenderFillRect(renderer, &r1);
+            SDL_SetRenderDrawColor(renderer, 0xff, 0xff, 0xff, 0x80);
+            SDL_Rect r2 = { offX+x, offY+bary, w, barh };
+            SDL_RenderFillRect(renderer, &r2);
+        }
+    }
+
+    static constexpr size_t NO_ROW = (size_t)-1;
+
+protected:
+    create_callback _createRow;
+    bind_callback _bindRow;
+    std::vector<size_t> _rowIndex; // row bound to _children[i]
+    size_t _rowCount = 0;
+    int _rowHeight = 32;
+    int _padding = 0;
+    int _spacing = 2;
+    int _scrollMaxY = 0;
+    int _scrollY = 0;
+
+    virtual void doLayout() override
+    {
+        relayout();
+    }
+};
+
+} // namespace Ui
+
+#endif // _UILIB_SCROLLLIST_H
@@ -20,6 +20,7 @@ public:
 
     virtual void addChild(Widget* w) override
     {
+        flushChildLayout(w);
         if (!_children.empty()) {
             auto& last = _children.back();
             w->setPosition({_padding, last->getTop() + last->getHeight() + _spacing});
@@ -31,26 +32,7 @@ public:
             setSize({w->getWidth()+2*_padding, w->getHeight()+2*_padding});
             Container::addChild(w);
         }
-        // keep track of max and min size
-        _maxSize = {-1,2*_padding};
-        _minSize = {0,2*_padding};
-        for (auto& child : _children) {
-            if (_maxSize.width<0 || _maxSize.width>(child->getLeft()+child->getMaxWidth()+_padding))
-                _maxSize.width=child->getLeft()+child->getMaxWidth()+_padding;
-            if (child->getLeft()+child->getMinWidth()+_padding>_minSize.width)
-                _minSize.width=child->getLeft()+child->getMinWidth()+_padding;
-            if (_maxSize.height != -1) {
-                if (child->getMaxHeight() == -1)
-                    _maxSize.height = -1; // undefined = no max
-                else
-                    _maxSize.height += child->getMaxHeight()+_spacing;
-            }
-        }
-        if (_maxSize.width >= 0 && _minSize.width>_maxSize.width)
-            _maxSize.width = _minSize.width;
-        if (_maxSize.height >= 0 && _minSize.height>_maxSize.height)
-            _maxSize.height = _minSize.height;
-        relayout(); // required to update scroll position
+        invalidateLayout(); // required to update min size and scroll position
     }
 
     // TODO: removeChild: update maxSize and minSize
@@ -77,11 +59,12 @@ public:
             int h = size.height - _children.back()->getTop()-_padding;
             if (h>0) _children.back()->setHeight(h);
         }
-        relayout(); // required to update scroll position + max scroll
+        invalidateLayout(); // required to update scroll position + max scroll
     }
 
     void relayout(bool isFixup=false) // TODO: virtual?
     {
+        if (!isFixup) beginLayoutPass();
         if (_scrollY > 0) _scrollY = 0;
         else if (_children.empty()) _scrollY = 0;
 
@@ -146,8 +129,12 @@ public:
 
     virtual void render(Renderer renderer, int offX, int offY) override
     {
-        // children
-        Container::render(renderer, offX, offY);
+        // children, clipped to our area so scrolled out parts are not rendered
+        SDL_Rect clip = { offX+_pos.left, offY+_pos.top, _size.width, _size.height };
+        if (pushClipRect(renderer, clip)) {
+            Container::render(renderer, offX, offY);
+            popClipRect(renderer);
+        }
         // scroll bar/position
         if (_scrollMaxY < 0 && _size.height > 0) {
             int x = _pos.left + _size.width - 3;
@@ -170,6 +157,35 @@ public:
 protected:
     int _scrollMaxY = 0;
     int _scrollY = 0;
+
+    virtual void doLayout() override
+    {
+        calcMinMax();
+        relayout();
+    }
+
+    void calcMinMax()
+    {
+        // keep track of max and min size
+        _maxSize = {-1,2*_padding};
+        _minSize = {0,2*_padding};
+        for (auto& child : _children) {
+            if (_maxSize.width<0 || _maxSize.width>(child->getLeft()+child->getMaxWidth()+_padding))
+                _maxSize.width=child->getLeft()+child->getMaxWidth()+_padding;
+            if (child->getLeft()+child->getMinWidth()+_padding>_minSize.width)
+                _minSize.width=child->getLeft()+child->getMinWidth()+_padding;
+            if (_maxSize.height != -1) {
+                if (child->getMaxHeight() == -1)
+                    _maxSize.height = -1; // undefined = no max
+                else
+                    _maxSize.height += child->getMaxHeight()+_spacing;
+            }
+        }
+        if (_maxSize.width >= 0 && _minSize.width>_maxSize.width)
+            _maxSize.width = _minSize.width;
+        if (_maxSize.height >= 0 && _minSize.height>_maxSize.height)
+            _maxSize.height = _minSize.height;
+    }
 };
 
 } // namespace Ui
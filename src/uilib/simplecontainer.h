@@ -27,6 +27,7 @@ public:
     virtual void addChild(Widget* child) override
     {
         if (!child) return;
+        flushChildLayout(child);
         Container::addChild(child);
         bool fireMin = calculateMinSize(child); // TODO; move this to Container?
         bool fireMax = calculateMaxSize(child);
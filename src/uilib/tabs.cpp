@@ -64,8 +64,10 @@ Tabs::~Tabs()
 
 void Tabs::addChild(Widget* w)
 {
+    flushChildLayout(w);
     w->setVisible(false);
     _children.push_back(w);
+    setParent(w, this);
     Button* btn = new Button(0,0,0,0,_font,"Tab");
     btn->setSize(btn->getMinSize());
     btn->onClick += {this, [this](void* sender,int x, int y, int btn) {
@@ -86,16 +88,18 @@ void Tabs::addChild(Widget* w)
             childIt++;
             n++;
         }
+        onActiveTabChanged.emit(this);
     }};
     _buttons.push_back(btn);
     _buttonbox->addChild(btn);
-    relayout();
+    invalidateLayout();
     if (_tab == nullptr) {
         _tab = w;
         _tabIndex = 0;
         _tabButton = btn;
         btn->setState(Button::State::PRESSED);
         _tab->setVisible(true);
+        onActiveTabChanged.emit(this);
     }
     // TODO: fire minsize changed signal?
 }
@@ -104,18 +108,21 @@ void Tabs::removeChild(Widget *w)
 {
     // remove tab and button
     {
+        int n = 0;
         auto childIt = _children.begin();
         auto buttonIt = _buttons.begin();
-        for (;childIt!=_children.end(); childIt++,buttonIt++) {
+        for (;childIt!=_children.end(); childIt++,buttonIt++,n++) {
             if (*childIt == w) {
                 _children.erase(childIt);
+                setParent(w, nullptr);
                 if (buttonIt != _buttons.end()) {
+                    if (*buttonIt == _tabButton) _tabButton = nullptr;
                     _buttonbox->removeChild(*buttonIt);
                     delete (*buttonIt);
                     _buttons.erase(buttonIt);
-                    break;
                 }
-                relayout();
+                if (n < _tabIndex) _tabIndex--;
+                invalidateLayout();
                 break;
             }
         }
@@ -123,16 +130,15 @@ void Tabs::removeChild(Widget *w)
     // if selected tab was removed, select next (or previous if no next)
     if (_tab == w) {
         _tab = nullptr;
-        auto it=_children.begin();
-        for (int i=_tabIndex; it!=_children.end() && i>0; it++, i--);
-        if (it != _children.end()) {
-            _tab = *it;
-        }
-        else {
-            _tabIndex--;
-             if (!_children.empty()) _tab = _children.back();
+        if (_tabIndex >= (int)_children.size()) _tabIndex = (int)_children.size() - 1;
+        if (_tabIndex < 0) _tabIndex = 0;
+        if (!_children.empty()) {
+            _tab = _children[_tabIndex];
+            _tabButton = getFromList(_buttons, _tabIndex);
+            if (_tabButton) _tabButton->setState(Button::State::PRESSED);
+            _tab->setVisible(true);
         }
-        if (_tab) _tab->setVisible(true);
+        onActiveTabChanged.emit(this);
     }
 }
 
@@ -142,7 +148,7 @@ void Tabs::setTabName(int index, const std::string& name)
     if (btn && btn->getText() != name) {
         btn->setText(name);
         btn->setSize(btn->getMinSize());
-        relayout();
+        invalidateLayout();
     }
 }
 
@@ -152,7 +158,7 @@ void Tabs::setTabIcon(int index, const void *data, size_t len)
     if (btn) {
         btn->setIcon(data, len);
         btn->setSize(btn->getMinSize());
-        relayout();
+        invalidateLayout();
     }
 }
 
@@ -186,6 +192,7 @@ const std::string& Tabs::getActiveTabName() const
 
 void Tabs::relayout()
 {
+    beginLayoutPass();
     _buttonbox->setWidth(getWidth()); // minHeight depends on width -> set first
     _buttonbox->relayout();
     int top = _buttonbox->getHeight() + _spacing;
@@ -213,12 +220,17 @@ void Tabs::relayout()
     _buttonbox->setWidth(_size.width); // NOTE: this change requires halign for buttonbox
 }
 
+void Tabs::doLayout()
+{
+    relayout();
+}
+
 void Tabs::render(Renderer renderer, int offX, int offY)
 {
     offX += _pos.left;
     offY += _pos.top;
     _buttonbox->render(renderer, offX, offY);
-    _tab->render(renderer, offX, offY);
+    if (_tab) renderChild(renderer, _tab, offX, offY);
 }
 
 void Tabs::setSize(Size size)
@@ -227,7 +239,7 @@ void Tabs::setSize(Size size)
     if (size.width < _minSize.width) size.width = _minSize.width;
     if (size.height < _minSize.height) size.height = _minSize.height;
     _size = size;
-    relayout();
+    invalidateLayout();
 }
 
 
@@ -28,12 +28,17 @@ public:
     virtual bool setActiveTab(int index);
     virtual const std::string& getActiveTabName() const;
 
+    Signal<> onActiveTabChanged;
+
     virtual bool isHit(int x, int y) const override {
         return _buttonbox->isHit(x - _pos.left, y - _pos.top) || Container::isHit(x, y);
     }
+    // tab buttons don't invalidate
+    virtual bool isRenderCacheable() const override { return false; }
 
 protected:
     void relayout();
+    virtual void doLayout() override;
     HFlexBox* _buttonbox;
     std::list<Button*> _buttons;
     FONT _font;
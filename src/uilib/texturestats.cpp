@@ -0,0 +1,98 @@
+#include "texturestats.h"
+#include <algorithm>
+#include <vector>
+
+namespace Ui {
+
+std::unordered_map<SDL_Texture*, TextureStats::Entry> TextureStats::_textures;
+size_t TextureStats::_bytes = 0;
+std::unordered_map<SDL_Renderer*, unsigned> TextureStats::_frames;
+size_t TextureStats::_budget = 0;
+
+SDL_Texture* TextureStats::created(SDL_Renderer* renderer, SDL_Texture* tex)
+{
+    if (tex) {
+        size_t bytes = getSize(tex);
+        const unsigned* frame = &_frames[renderer];
+        _textures[tex] = {renderer, bytes, *frame, frame, nullptr};
+        _bytes += bytes;
+    }
+    return tex;
+}
+
+void TextureStats::destroy(SDL_Texture* tex)
+{
+    if (!tex) return;
+    auto it = _textures.find(tex);
+    if (it != _textures.end()) {
+        _bytes -= it->second.bytes;
+        _textures.erase(it);
+    }
+    SDL_DestroyTexture(tex);
+}
+
+void TextureStats::setEvictable(SDL_Texture* tex, forget_callback forget)
+{
+    auto it = _textures.find(tex);
+    if (it != _textures.end()) it->second.forget = forget;
+}
+
+size_t TextureStats::getBytes(SDL_Renderer* renderer)
+{
+    size_t bytes = 0;
+    for (const auto& pair: _textures)
+        if (pair.second.renderer == renderer) bytes += pair.second.bytes;
+    return bytes;
+}
+
+void TextureStats::releaseRenderer(SDL_Renderer* renderer)
+{
+    // textures are destroyed with the renderer
+    for (auto it = _textures.begin(); it != _textures.end();) {
+        if (it->second.renderer == renderer) {
+            _bytes -= it->second.bytes;
+            it = _textures.erase(it);
+        } else {
+            it++;
+        }
+    }
+    _frames.erase(renderer);
+}
+
+size_t TextureStats::endFrame()
+{
+    size_t evicted = 0;
+    if (_budget && _bytes > _budget) {
+        // least recently drawn first, textures drawn in the last frame of
+        // their window are kept
+        std::vector<std::pair<unsigned, SDL_Texture*>> candidates;
+        for (const auto& pair: _textures) {
+            unsigned frame = *pair.second.frame;
+            if (pair.second.forget && pair.second.lastUse != frame)
+                candidates.push_back({frame - pair.second.lastUse, pair.first});
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first;
+        });
+        for (const auto& candidate: candidates) {
+            if (_bytes <= _budget) break;
+            auto it = _textures.find(candidate.second);
+            if (it == _textures.end()) continue; // destroyed by a previous forget()
+            auto forget = std::move(it->second.forget);
+            forget();
+            destroy(candidate.second);
+            evicted++;
+        }
+    }
+    return evicted;
+}
+
+size_t TextureStats::getSize(SDL_Texture* tex)
+{
+    // renderers don't tell, assume 32bit
+    int w = 0, h = 0;
+    if (SDL_QueryTexture(tex, nullptr, nullptr, &w, &h) != 0) return 0;
+    return (size_t)w * (size_t)h * 4;
+}
+
+} // namespace Ui
@@ -0,0 +1,67 @@
+#ifndef _UILIB_TEXTURESTATS_H
+#define _UILIB_TEXTURESTATS_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+#include <functional>
+#include <unordered_map>
+
+namespace Ui {
+
+// Keeps track of the number and estimated size of textures created by uilib,
+// per renderer (= window), and evicts textures that can be re-created by
+// their owner when over budget.
+// Use created() and destroy() instead of creating/destroying textures directly.
+class TextureStats final {
+public:
+    // called when the texture gets evicted; the owner has to drop its pointer,
+    // the texture is destroyed by TextureStats afterwards
+    typedef std::function<void(void)> forget_callback;
+
+    static SDL_Texture* created(SDL_Renderer* renderer, SDL_Texture* tex);
+    static void destroy(SDL_Texture* tex);
+
+    // allow eviction of a texture that was not drawn in its window's last frame
+    static void setEvictable(SDL_Texture* tex, forget_callback forget);
+    // mark texture as drawn in the current frame of its renderer
+    static void used(SDL_Texture* tex)
+    {
+        auto it = _textures.find(tex);
+        if (it != _textures.end()) it->second.lastUse = *it->second.frame;
+    }
+    // call before a renderer draws a frame; windows are drawn at different
+    // rates, so age is counted in frames of the texture's own renderer
+    static void beginFrame(SDL_Renderer* renderer) { _frames[renderer]++; }
+    // call before destroying a renderer
+    static void releaseRenderer(SDL_Renderer* renderer);
+
+    static size_t getCount() { return _textures.size(); }
+    static size_t getBytes() { return _bytes; }
+    static size_t getBytes(SDL_Renderer* renderer);
+
+    // budget in bytes for all windows, 0 = unlimited
+    static void setBudget(size_t bytes) { _budget = bytes; }
+    static size_t getBudget() { return _budget; }
+    // call after rendering windows; returns number of evicted textures
+    static size_t endFrame();
+
+private:
+    struct Entry {
+        SDL_Renderer* renderer;
+        size_t bytes;
+        unsigned lastUse;
+        const unsigned* frame; // points into _frames
+        forget_callback forget;
+    };
+
+    static std::unordered_map<SDL_Texture*, Entry> _textures;
+    static std::unordered_map<SDL_Renderer*, unsigned> _frames; // frame number by renderer
+    static size_t _bytes;
+    static size_t _budget;
+
+    static size_t getSize(SDL_Texture* tex);
+};
+
+} // namespace Ui
+
+#endif // _UILIB_TEXTURESTATS_H
@@ -5,7 +5,10 @@
 #include <time.h> 
 #include <stdint.h>
 #include "../core/fileutil.h"
+#include "../core/perfstats.h"
 #include "droptype.h"
+#include "texturestats.h"
+#include "imagedecoder.h"
 
 
 #if defined __LINUX__ || defined __FREEBSD__ || defined __OPENBSD__ || defined __NETBSD__
@@ -104,6 +107,7 @@ Ui::~Ui()
     // TODO: DelEventWatch?
     SDL_SetEventFilter(nullptr, nullptr);
 #endif
+    ImageDecoder::shutdown();
     TTF_Quit();
     SDL_Quit();
 }
@@ -136,6 +140,14 @@ int Ui::eventFilter(void* userdata, SDL_Event *ev)
     if (ev->type == SDL_WINDOWEVENT) {
         if (ev->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
             if (!ui->_eventMutex.try_lock()) return 1; // already handling events, skip resize / push to list instead
+            // relayout at most once per frame, the event is still queued and handled in render()
+            uint32_t now = SDL_GetTicks();
+            uint32_t frameTime = 1000 / (ui->_fpsLimit ? ui->_fpsLimit : DEFAULT_FPS_LIMIT);
+            if (now - ui->_lastLiveResize < frameTime) {
+                ui->_eventMutex.unlock();
+                return 1;
+            }
+            ui->_lastLiveResize = now;
             int x = ev->window.data1;
             int y = ev->window.data2;
             auto winit = ui->_windows.find(ev->window.windowID);
@@ -172,7 +184,19 @@ bool Ui::render()
         }
     }
 
-    #define FRAME_TIME (1000/_fpsLimit) // TODO: microseconds
+    // nothing to render -> only keep event handling and state updates going
+    unsigned fpsLimit = _fpsLimit;
+    bool renderable = false;
+    for (const auto& pair : _windows) {
+        if (pair.second->isRenderable()) {
+            renderable = true;
+            break;
+        }
+    }
+    if (!renderable && fpsLimit > HIDDEN_FPS_LIMIT)
+        fpsLimit = HIDDEN_FPS_LIMIT;
+
+    #define FRAME_TIME (1000/fpsLimit) // TODO: microseconds
     
     uint32_t t0 = SDL_GetTicks(); // TODO: microseconds
     uint32_t t1 = t0;
@@ -209,6 +233,7 @@ bool Ui::render()
         
         SDL_Event ev;
         while (SDL_PollEvent(&ev)) {
+            PerfStats::Timer timer(PerfStats::Section::EVENTS);
             switch (ev.type) {
                 case SDL_QUIT: {
                     printf("Ui: Quit\n");
@@ -296,6 +321,7 @@ bool Ui::render()
                         auto winit = _windows.find(ev.window.windowID);
                         if (winit != _windows.end()) {
                             winit->second->setSize({x,y});
+                            winit->second->scheduleRender();
                             destructiveEvent = true;
                         }
                         EVENT_UNLOCK(this);
@@ -338,6 +364,16 @@ bool Ui::render()
                             }
                         }
                     }
+                    else if (ev.window.event == SDL_WINDOWEVENT_EXPOSED ||
+                            ev.window.event == SDL_WINDOWEVENT_RESTORED) {
+                        // contents may be lost, don't wait for the window's frame budget
+                        EVENT_LOCK(this);
+                        auto winit = _windows.find(ev.window.windowID);
+                        if (winit != _windows.end()) {
+                            winit->second->scheduleRender();
+                        }
+                        EVENT_UNLOCK(this);
+                    }
                     #if 0 // this is not neccessary
                     else if (ev.window.event == SDL_WINDOWEVENT_TAKE_FOCUS) {
                         // focus offered -> grab focus
@@ -412,25 +448,31 @@ bool Ui::render()
 #if defined __EMSCRIPTEN__
     } while (false); // waiting for events makes no sense in a browser context
 #else
-    } while (_fpsLimit && (FRAME_TIME>_lastRenderDuration && t1-t0+1 < FRAME_TIME-_lastRenderDuration)); // TODO: microseconds?
+    } while (fpsLimit && (FRAME_TIME>_lastRenderDuration && t1-t0+1 < FRAME_TIME-_lastRenderDuration)); // TODO: microseconds?
 #endif
     
     {
         EVENT_LOCK(this);
-        for (auto win: _windows)
-            win.second->render();
+        PerfStats::Timer timer(PerfStats::Section::RENDER);
+        uint32_t now = SDL_GetTicks();
+        for (auto win: _windows) {
+            if (win.second->isRenderDue(now))
+                win.second->render();
+        }
+        TextureStats::endFrame(); // evicts textures if over budget
+
         EVENT_UNLOCK(this);
     }
 
     uint32_t t2 = SDL_GetTicks();
     uint32_t td = t2-t1;
 #if !defined VSYNC && !defined __EMSCRIPTEN__
-    if (_fpsLimit)
+    if (fpsLimit)
     {
         // usleep the rest between last frame's timestamp and now to have a constant frame time
         uint64_t timestamp = getMicroTicks();
         uint64_t now = timestamp;
-        uint64_t t = 1000000/_fpsLimit;
+        uint64_t t = 1000000/fpsLimit;
         if (now-_lastFrameMicroTimestamp<t) {
             usleep(t-(now-_lastFrameMicroTimestamp));
         }
@@ -9,6 +9,8 @@
 
 #define DEFAULT_FPS_LIMIT 120
 #define DEFAULT_SOFTWARE_FPS_LIMIT 60
+#define DEFAULT_BROADCAST_FPS_LIMIT 30
+#define HIDDEN_FPS_LIMIT 30 // event and state updates while no window is shown
 
 namespace Ui {
 
@@ -32,6 +34,7 @@ protected:
     unsigned _softwareFpsLimit = DEFAULT_SOFTWARE_FPS_LIMIT;
 
     std::mutex _eventMutex;
+    uint32_t _lastLiveResize = 0; // ticks of last resize render from eventFilter
     static int eventFilter(void *userdata, SDL_Event *event);
 
     std::list<Hotkey> _hotkeys;
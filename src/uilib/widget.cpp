@@ -1,3 +1,9 @@
 #include "widget.h"
 
 SDL_Cursor *Ui::Widget::_defaultCursor = nullptr;
+
+void Ui::Widget::invalidate()
+{
+    for (Widget* w = this; w; w = w->_parent)
+        w->_renderCacheValid = false;
+}
@@ -122,6 +122,10 @@ protected:
     static SDL_Cursor *_defaultCursor;
     Spacing _margin = {0,0,0,0};
     bool _dropShadow = false;
+    Widget* _parent = nullptr; // set by Container, used by invalidate()
+    bool _renderCacheValid = false; // see Container::setRenderCache()
+
+    static void setParent(Widget* w, Widget* parent) { w->_parent = parent; }
     
 public:
     virtual ~Widget()
@@ -141,7 +145,7 @@ public:
     
     virtual void render(Renderer renderer, int offX, int offY)=0;
     bool getEnabled() const { return _enabled; }
-    virtual void setEnabled(bool enabled) { _enabled = enabled; }
+    virtual void setEnabled(bool enabled) { _enabled = enabled; invalidate(); }
     
     virtual const Position& getPosition() const { return _pos; }
     virtual int getLeft() const { return _pos.left; }
@@ -156,12 +160,12 @@ public:
     int getVGrow() const { return _vGrow; }
     void setLeft(int x) { setPosition({x,_pos.top}); }
     void setTop(int y) { setPosition({_pos.left,y}); }
-    virtual void setPosition(const Position& pos) { _pos = pos; }
+    virtual void setPosition(const Position& pos) { _pos = pos; invalidate(); }
     void setWidth(int w) { setSize({w,_size.height}); }
     void setHeight(int h) { setSize({_size.width,h}); }
-    virtual void setSize(Size size) { _size = size; }
+    virtual void setSize(Size size) { if (size == _size) return; _size = size; invalidate(); }
     virtual void setGrow(int h, int v) { _hGrow=h; _vGrow=v; }
-    virtual void setBackground(Color color) { _backgroundColor = color; }
+    virtual void setBackground(Color color) { _backgroundColor = color; invalidate(); }
     virtual int getMinX() const { return _pos.left; }
     virtual int getMinY() const { return _pos.top; }
     virtual int getMaxX() const { return _pos.left + _size.width - 1; }
@@ -187,14 +191,29 @@ public:
     virtual void setMinSize(Size size) { _minSize = size; }
     virtual void setMaxSize(Size size) { _maxSize = size; }
     
-    void setVisible(bool visible) { _visible = visible; }
+    void setVisible(bool visible) { _visible = visible; invalidate(); }
     bool getVisible() const { return _visible; }
+    // false if this or any parent is hidden, i.e. in an inactive tab
+    bool isShown() const
+    {
+        for (const Widget* w = this; w; w = w->_parent)
+            if (!w->_visible) return false;
+        return true;
+    }
 
-    void setDropShaodw(bool dropShadow) { _dropShadow = dropShadow; }
+    void setDropShaodw(bool dropShadow) { _dropShadow = dropShadow; invalidate(); }
     bool getDropShadow() const { return _dropShadow; }
 
     virtual bool isHover(Widget* w) const { return (w == this); }
 
+    // has to be called when the rendered content of the widget changes,
+    // marks cached renders of this and all parents as outdated
+    void invalidate();
+    // returns true if every change of the widget's content calls invalidate(),
+    // so it can be part of a cached subtree, see Container::setRenderCache()
+    virtual bool isRenderCacheable() const { return false; }
+    virtual bool hasRenderCache() const { return false; }
+
     void setCursor(Cursor cur) {
         bool isDisplayed = false;
         if (!_defaultCursor) {
@@ -216,7 +235,7 @@ public:
         if (isDisplayed) SDL_SetCursor(_cursor);
     }
 
-    void setMargin(const Spacing& margin) { _margin = margin; }
+    void setMargin(const Spacing& margin) { _margin = margin; invalidate(); }
     const Spacing& getMargin() const { return _margin; }
 
     Signal<int,int,int> onClick; // TODO: MouseClickEventArgs& ?
@@ -0,0 +1,106 @@
+#ifndef _UILIB_WIDGETPOOL_H
+#define _UILIB_WIDGETPOOL_H
+
+#include "container.h"
+#include <list>
+#include <map>
+#include <string>
+
+namespace Ui {
+
+// Keeps widgets of short-lived ui, i.e. tooltips, to reuse them instead of
+// creating them again. Widgets are registered with add() under a key that
+// describes their content, recycle() detaches them from a removed tree and
+// take() returns them for the same key. A key has to be used for a single
+// widget type. Free widgets are hidden, so they are not considered shown.
+class WidgetPool final {
+public:
+    static constexpr size_t MAX_FREE = 256; // oldest free widgets get deleted
+
+    ~WidgetPool()
+    {
+        clear();
+    }
+
+    // returns a free widget for key or nullptr
+    template<class T>
+    T* take(const std::string& key)
+    {
+        auto it = _free.find(key);
+        if (it == _free.end()) return nullptr;
+        Widget* w = it->second;
+        _free.erase(it);
+        _order.remove(w);
+        w->setVisible(true);
+        return static_cast<T*>(w);
+    }
+
+    // registers a new widget, so it can be reused after recycle()
+    template<class T>
+    T* add(const std::string& key, T* w)
+    {
+        _keys[w] = key;
+        w->onDestroy += {this, [this](void* sender) {
+            _keys.erase((Widget*)sender);
+        }};
+        return w;
+    }
+
+    // detaches registered widgets of a tree and deletes the rest,
+    // w has to be removed from its parent before
+    void recycle(Widget* w)
+    {
+        auto container = dynamic_cast<Container*>(w);
+        if (container) {
+            auto children = container->getChildren();
+            for (auto child: children) {
+                container->removeChild(child);
+                recycle(child);
+            }
+        }
+        auto it = _keys.find(w);
+        if (it == _keys.end()) {
+            delete w;
+            return;
+        }
+        w->setVisible(false);
+        _free.emplace(it->second, w);
+        _order.push_back(w);
+        while (_order.size() > MAX_FREE) {
+            Widget* old = _order.front();
+            _order.pop_front();
+            auto range = _free.equal_range(_keys[old]);
+            for (auto fit = range.first; fit != range.second; ++fit) {
+                if (fit->second == old) {
+                    _free.erase(fit);
+                    break;
+                }
+            }
+            delete old;
+        }
+    }
+
+    // deletes free widgets and forgets about widgets in use
+    void clear()
+    {
+        for (auto& pair: _keys)
+            pair.first->onDestroy -= this;
+        _keys.clear();
+        _free.clear();
+        auto order = std::move(_order);
+        _order.clear();
+        for (auto w: order)
+            delete w;
+    }
+
+    size_t getFreeCount() const { return _order.size(); }
+
+private:
+    std::map<Widget*, std::string> _keys; // all registered widgets
+    std::multimap<std::string, Widget*> _free;
+    std::list<Widget*> _order; // free widgets, oldest first
+};
+
+} // namespace Ui
+
+#endif // _UILIB_WIDGETPOOL_H
@@ -1,6 +1,8 @@
 #include "window.h"
 #include "../core/assets.h"
 #include "../ui/defaults.h" // DEFAULT_FONT_*
+#include "glyphatlas.h"
+#include "texturestats.h"
 #include <SDL2/SDL_syswm.h>
 #include <algorithm>
 
@@ -57,6 +59,8 @@ Window::~Window()
     // NOTE: we have to destroy children before destroying the renderer
     clearChildren();
     if (_fontStore) delete _fontStore;
+    if (_ren) GlyphAtlas::releaseRenderer(_ren);
+    if (_ren) TextureStats::releaseRenderer(_ren);
     if (_ren) SDL_DestroyRenderer(_ren);
     if (_win) SDL_DestroyWindow(_win);
     _font = nullptr;
@@ -82,16 +86,48 @@ void Window::present()
 
 void Window::render(Renderer renderer, int offX, int offY)
 {
+    flushLayout(); // resolve layout changes since the last frame
     Container::render(renderer, offX, offY);
 }
 
 void Window::render()
 {
+    uint32_t now = SDL_GetTicks();
+    if (_fpsLimit) {
+        // advance by the ideal frame time, so frames that are rendered late
+        // do not lower the frame rate, see isRenderDue().
+        // resync if more than a frame behind or rendered early (scheduled).
+        uint32_t period = 1000 / _fpsLimit;
+        _lastRender += period;
+        int32_t late = (int32_t)(now - _lastRender);
+        if (late < 0 || (uint32_t)late >= period) _lastRender = now;
+    } else {
+        _lastRender = now;
+    }
+    _renderScheduled = false;
+    TextureStats::beginFrame(_ren);
     clear();
     render(_ren, 0, 0);
     present();
 }
 
+size_t Window::getTextureBytes() const
+{
+    return TextureStats::getBytes(_ren);
+}
+
+bool Window::isRenderable() const
+{
+    return !(SDL_GetWindowFlags(_win) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN));
+}
+
+bool Window::isRenderDue(uint32_t ticks) const
+{
+    if (!isRenderable()) return false;
+    if (_renderScheduled || !_fpsLimit) return true;
+    return ticks - _lastRender >= 1000 / _fpsLimit;
+}
+
 Window::ID Window::getID()
 {
     return SDL_GetWindowID(_win);
@@ -21,6 +21,9 @@ protected:
     SDL_Renderer *_ren = nullptr;
     FontStore *_fontStore = nullptr; // TODO; pass as argument to window constructor?
     FONT _font = nullptr;
+    unsigned _fpsLimit = 0; // 0 = render every frame
+    uint32_t _lastRender = 0; // ticks, ideal time of the last frame if limited
+    bool _renderScheduled = false;
     
     void clear();
     void present();
@@ -51,6 +54,18 @@ public:
     void grabFocus();
 
     bool isAccelerated();
+    // estimated memory used by textures of this window
+    size_t getTextureBytes() const;
+
+    // limit rendering of this window below the global frame rate, 0 = no limit
+    void setFPSLimit(unsigned fps) { _fpsLimit = fps; }
+    unsigned getFPSLimit() const { return _fpsLimit; }
+    // force render in the next frame, i.e. after a resize
+    void scheduleRender() { _renderScheduled = true; }
+    // false if minimized or hidden
+    bool isRenderable() const;
+    // true if renderable and the frame budget is used up
+    bool isRenderDue(uint32_t ticks) const;
 
     Signal<int, int, DropType, std::string> onDrop; // x, y, type, data
 };
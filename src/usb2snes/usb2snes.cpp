@@ -1,5 +1,6 @@
 #include "usb2snes.h"
 #include <cstdio>
+#include <cstring>
 #include <thread>
 #include <mutex>
 #include <chrono>
@@ -171,7 +172,7 @@ USB2SNES::USB2SNES(const std::string& name)
             }
             case Op::READ:
             {
-                std::lock_guard<std::mutex> datalock(datamutex);
+                // data and rxbuf are only used by this thread
                 #ifndef MINIMAL_LOGGING
                 printf("Read result: @$%06x=<%u>0x%02x...\n", (unsigned)last_addr, (unsigned)last_len, (uint8_t)msg->get_payload()[0]);
                 #endif
@@ -192,11 +193,8 @@ USB2SNES::USB2SNES(const std::string& name)
                     printf("Read $%06x expected %u bytes but got %u bytes answer\n", (unsigned)last_addr, last_len, (unsigned)(rxbuf.size()+msg->get_payload().size()));
                 }
                 if (last_len<read_len) read_len = last_len;
-                for (unsigned i=0; i<read_len; i++) {
-                    if (data[last_addr+i] != (uint8_t)rxbuf[i])
-                        data_changed = true;
-                    data[last_addr+i] = (uint8_t)rxbuf[i];
-                }
+                if (data.set(last_addr, (const uint8_t*)rxbuf.data(), read_len))
+                    batch_changed = true;
                 rxbuf.clear(); 
                 break;
             }
@@ -211,6 +209,9 @@ USB2SNES::USB2SNES(const std::string& name)
             tmp_snes_connected = snes_connected;
         }
         if (!tmp_snes_connected) {
+            // don't hold back reads of an interrupted round
+            publishBatch();
+            last_watch = 0;
             // limit to 10 times a second
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
             // rescan
@@ -222,6 +223,9 @@ USB2SNES::USB2SNES(const std::string& name)
             bool no_rom_read = (it == features.end()) ? false : it->second;
             auto& actwatchlist = no_rom_read ? no_rom_watchlist : watchlist;
             if (actwatchlist.empty()) {
+                // all watches were removed during the round
+                publishBatch();
+                last_watch = 0;
                 watchlock.unlock();
                 // limit to 10 times a second
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -233,6 +237,7 @@ USB2SNES::USB2SNES(const std::string& name)
                 last_op = Op::READ;
                 if (last_watch >= actwatchlist.size()) {
                     last_watch = 0;
+                    publishBatch(); // round complete
                     if (update_interval>0) { // limit updates per second
                         unsigned long t = (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - last_update).count();
                         {
@@ -343,6 +348,8 @@ USB2SNES::USB2SNES(const std::string& name)
             ws_connected = false;
             snes_connected = false;
         }
+        publishBatch();
+        last_watch = 0;
         last_op = Op::NONE;
         printf("* connection to %s closed *\n", uri.c_str());
     });
@@ -448,6 +455,8 @@ bool USB2SNES::dostuff()
     bool res = false;
     {
         std::lock_guard<std::mutex> datalock(datamutex);
+        if (data_changed)
+            published.publish(snapshot);
         res |= data_changed;
         data_changed = false;
     }
@@ -458,6 +467,69 @@ bool USB2SNES::dostuff()
     }
     return res;
 }
+void USB2SNES::Memory::get(uint32_t addr, size_t len, uint8_t* out) const
+{
+    while (len) {
+        if (addr >= SIZE) {
+            memset(out, 0, len);
+            return;
+        }
+        uint32_t offset = addr & (PAGE_SIZE-1);
+        size_t n = std::min(len, (size_t)(PAGE_SIZE - offset));
+        const auto& page = pages[addr >> PAGE_BITS];
+        if (page)
+            memcpy(out, page.get() + offset, n);
+        else
+            memset(out, 0, n);
+        addr += (uint32_t)n;
+        out += n;
+        len -= n;
+    }
+}
+
+bool USB2SNES::Memory::set(uint32_t addr, const uint8_t* src, size_t len)
+{
+    bool changed = false;
+    while (len && addr < SIZE) {
+        uint32_t offset = addr & (PAGE_SIZE-1);
+        size_t n = std::min(len, (size_t)(PAGE_SIZE - offset));
+        auto& page = pages[addr >> PAGE_BITS];
+        if (!page)
+            page.reset(new uint8_t[PAGE_SIZE]()); // zeroed, same as an unknown byte
+        if (memcmp(page.get() + offset, src, n) != 0) {
+            memcpy(page.get() + offset, src, n);
+            markDirty(addr >> PAGE_BITS);
+            changed = true;
+        }
+        addr += (uint32_t)n;
+        src += n;
+        len -= n;
+    }
+    return changed;
+}
+
+void USB2SNES::Memory::publish(Memory& dst)
+{
+    for (size_t page: dirty_pages) {
+        dirty[page] = false;
+        if (!pages[page]) continue;
+        if (!dst.pages[page])
+            dst.pages[page].reset(new uint8_t[PAGE_SIZE]);
+        memcpy(dst.pages[page].get(), pages[page].get(), PAGE_SIZE);
+        dst.markDirty(page);
+    }
+    dirty_pages.clear();
+}
+
+void USB2SNES::Memory::clear()
+{
+    for (auto& page: pages)
+        page.reset();
+    for (size_t page: dirty_pages)
+        dirty[page] = false;
+    dirty_pages.clear();
+}
+
 uint32_t USB2SNES::mapaddr(uint32_t addr)
 {
     // WRAM
@@ -546,18 +618,20 @@ void USB2SNES::addWatch(uint32_t addr, unsigned len)
 {
     uint32_t usb2snes_addr = mapaddr(addr);
     {
+        // lists are sorted; this is called for every read of 0 from Lua,
+        // so keep it cheap when the address is already watched
         std::lock_guard<std::mutex> watchlock(watchmutex);
         for (size_t i=0; i<len; i++) {
-            if (std::find(watchlist.begin(), watchlist.end(), usb2snes_addr+i)==watchlist.end())
-                watchlist.push_back(usb2snes_addr+i);
+            auto it = std::lower_bound(watchlist.begin(), watchlist.end(), usb2snes_addr+i);
+            if (it == watchlist.end() || *it != usb2snes_addr+i)
+                watchlist.insert(it, usb2snes_addr+i);
         }
-        sort(watchlist.begin(), watchlist.end());
         for (size_t i=0; i<len; i++) {
             if (is_rom(usb2snes_addr+i)) continue;
-            if (std::find(no_rom_watchlist.begin(), no_rom_watchlist.end(), usb2snes_addr+i)==no_rom_watchlist.end())
-                no_rom_watchlist.push_back(usb2snes_addr+i);
+            auto it = std::lower_bound(no_rom_watchlist.begin(), no_rom_watchlist.end(), usb2snes_addr+i);
+            if (it == no_rom_watchlist.end() || *it != usb2snes_addr+i)
+                no_rom_watchlist.insert(it, usb2snes_addr+i);
         }
-        sort(no_rom_watchlist.begin(), no_rom_watchlist.end());
     }
 }
 void USB2SNES::removeWatch(uint32_t addr, unsigned len)
@@ -577,10 +651,9 @@ uint8_t USB2SNES::read(uint32_t addr)
 {
     uint32_t usb2snes_addr = mapaddr(addr);
 #ifdef USB2SNES_ALLOW_READ_WITHOUT_WATCH
-    uint8_t val;
+    uint8_t val = snapshot.get(usb2snes_addr);
     {
-        std::lock_guard<std::mutex> datalock(datamutex);
-        val = data[usb2snes_addr];
+        std::lock_guard<std::mutex> watchlock(watchmutex);
         for (const auto& w: watchlist)
             if (w >= usb2snes_addr) return val;
     }
@@ -588,10 +661,8 @@ uint8_t USB2SNES::read(uint32_t addr)
     addWatch(addr);
     return val;
 #else
-    {
-        std::lock_guard<std::mutex> datalock(datamutex);
-        return data[usb2snes_addr];
-    }
+    // snapshot is only written by dostuff() on the same thread
+    return snapshot.get(usb2snes_addr);
 #endif
 }
 
@@ -601,9 +672,9 @@ bool USB2SNES::read(uint32_t addr, unsigned len, void* out)
     uint32_t usb2snes_addr = mapaddr(addr);
 #ifdef USB2SNES_ALLOW_READ_WITHOUT_WATCH
     bool missing = true;
+    snapshot.get(usb2snes_addr, len, dst);
     {
-        std::lock_guard<std::mutex> datalock(datamutex);
-        for (size_t i=0; i<len; i++) dst[i] = data[usb2snes_addr+i];
+        std::lock_guard<std::mutex> watchlock(watchmutex);
         for (size_t i=0; i<watchlist.size(); i++) {
             if (watchlist[i] == usb2snes_addr) {
                 if (watchlist.size()>=i+len && watchlist[i+len-1] == usb2snes_addr+len-1)
@@ -616,10 +687,7 @@ bool USB2SNES::read(uint32_t addr, unsigned len, void* out)
     }
     if (missing) addWatch(addr, len);
 #else
-    {
-        std::lock_guard<std::mutex> datalock(datamutex);
-        for (size_t i=0; i<len; i++) dst[i] = data[usb2snes_addr+i];
-    }
+    snapshot.get(usb2snes_addr, len, dst);
     return true;
 #endif
 }
@@ -635,7 +703,26 @@ bool USB2SNES::hasFeature(std::string feat)
 void USB2SNES::clearCache()
 {
     std::lock_guard<std::mutex> lock(datamutex);
-    data.clear();
+    // data belongs to the worker, it clears it after the current round.
+    // reads of the round in flight are discarded on purpose, see publishBatch()
+    clear_requested = true;
+    published.clear();
+    snapshot.clear();
+}
+
+void USB2SNES::publishBatch()
+{
+    std::lock_guard<std::mutex> lock(datamutex);
+    if (clear_requested) {
+        // the round may have started before clearCache(), so drop it as well
+        data.clear();
+        clear_requested = false;
+        batch_changed = false;
+    } else if (batch_changed) {
+        data.publish(published);
+        data_changed = true;
+        batch_changed = false;
+    }
 }
 
 std::string USB2SNES::getDeviceName()
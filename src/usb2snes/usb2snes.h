@@ -8,6 +8,8 @@
 #include <chrono>
 #include <vector>
 #include <string>
+#include <memory>
+#include <stdint.h>
 
 class USB2SNES {
     public:
@@ -86,6 +88,39 @@ class USB2SNES {
             bool operator==(const Version& other) const { return compare(other)==0; }
             bool operator!=(const Version& other) const { return !(*this==other); }
         };
+        // Mirror of the 24bit usb2snes address space. Pages are allocated on
+        // first write, so a full WRAM mirror takes 128KiB. Unknown bytes read as 0.
+        // Changed pages are tracked, so only those get copied by publish().
+        struct Memory {
+            static constexpr unsigned PAGE_BITS = 12;
+            static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+            static constexpr uint32_t SIZE = 0x1000000;
+            static constexpr size_t PAGE_COUNT = SIZE >> PAGE_BITS;
+
+            uint8_t get(uint32_t addr) const {
+                if (addr >= SIZE) return 0;
+                const auto& page = pages[addr >> PAGE_BITS];
+                return page ? page[addr & (PAGE_SIZE-1)] : 0;
+            }
+            void get(uint32_t addr, size_t len, uint8_t* out) const;
+            // returns true if any byte changed
+            bool set(uint32_t addr, const uint8_t* src, size_t len);
+            // copies pages that changed since the last publish to dst
+            void publish(Memory& dst);
+            void clear();
+
+        private:
+            std::unique_ptr<uint8_t[]> pages[PAGE_COUNT];
+            bool dirty[PAGE_COUNT] = {};
+            std::vector<size_t> dirty_pages;
+
+            void markDirty(size_t page) {
+                if (dirty[page]) return;
+                dirty[page] = true;
+                dirty_pages.push_back(page);
+            }
+        };
+
         WSClient client;
         WSClient::connection_ptr conn;
         // we have 1 mutex per data access
@@ -121,7 +156,15 @@ class USB2SNES {
         std::string rxbuf;
         std::vector<uint32_t> watchlist;
         std::vector<uint32_t> no_rom_watchlist;
-        std::map<uint32_t, uint8_t> data;
+        // Read results go to data, which is only used by the worker. After
+        // each full round of reads, changes are published under datamutex and
+        // picked up into snapshot by dostuff(), so reads from the main thread
+        // see whole rounds and do not need to lock.
+        Memory data;
+        Memory published;
+        Memory snapshot;
+        bool batch_changed = false;
+        bool clear_requested = false;
         bool data_changed = true;
         bool state_changed = true;
         std::chrono::system_clock::time_point last_update;
@@ -135,6 +178,9 @@ class USB2SNES {
         Version backend_version;
         bool is_qusb2snes_uri = false;
         size_t next_uri = 0;
+
+        // hands reads of the current round to the main thread, worker only
+        void publishBatch();
         size_t optimum_read_block_size = 512; // NOTE: qusb2snes 0.7.19 on linux read takes 20ms/128B, so "native" 512 has worse performance. TODO: fix this in qusb2snes
         size_t read_holes_are_free = true;//false;
         Mapping mapping = Mapping::UNKNOWN;
@@ -147,12 +193,10 @@ T USB2SNES::readInt(uint32_t addr)
 {
     T res=0;
     addr = mapaddr(addr);
-    {
-        std::lock_guard<std::mutex> datalock(datamutex);
-        for (size_t n=0; n<sizeof(T); n++) {
-            res <<= 8;
-            res += data[addr+sizeof(T)-n-1];
-        }
+    // snapshot is only written by dostuff() on the same thread
+    for (size_t n=0; n<sizeof(T); n++) {
+        res <<= 8;
+        res += snapshot.get(addr+sizeof(T)-n-1);
     }
     return res;
 }
@@ -0,0 +1,52 @@
+// Checks that a TrackerView rebuilds once a layout it references gets added
+// by a later AddLayouts() call.
+// Build and run with `make test`.
+
+#define SDL_MAIN_HANDLED
+#include "../src/core/pack.h"
+#include "../src/core/tracker.h"
+#include "../src/ui/trackerview.h"
+#include "../src/uilib/fontstore.h"
+#include "../src/luaglue/lua.h"
+#include <stdio.h>
+
+
+struct TestView : Ui::TrackerView {
+    using TrackerView::TrackerView;
+    bool relayoutPending() const { return _relayoutRequired; }
+};
+
+int main(int argc, char** argv)
+{
+    const char* path = (argc > 1) ? argv[1] : "test/packs/layoutrefs";
+    lua_State* L = luaL_newstate();
+    Pack pack(path);
+    if (!pack.isValid()) {
+        fprintf(stderr, "%s: not a valid pack\n", path);
+        return 1;
+    }
+    Tracker tracker(&pack, L);
+    Ui::FontStore fonts;
+    bool ok = true;
+    {
+        tracker.AddLayouts("a.json"); // references "b", which does not exist yet
+        TestView view(0, 0, 640, 480, &tracker, "tracker_default", &fonts);
+        view.relayout();
+        if (!view.getChildren().empty()) {
+            fprintf(stderr, "Built a layout that does not exist\n");
+            ok = false;
+        }
+        tracker.AddLayouts("b.json");
+        if (!view.relayoutPending()) {
+            fprintf(stderr, "Adding a referenced layout did not request a relayout\n");
+            ok = false;
+        }
+        view.relayout();
+        if (view.getChildren().empty()) {
+            fprintf(stderr, "Referenced layout was not built after it was added\n");
+            ok = false;
+        }
+    }
+    lua_close(L);
+    return ok ? 0 : 1;
+}